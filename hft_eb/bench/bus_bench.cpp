@@ -0,0 +1,179 @@
+// EventBus 发布开销基准
+// 对比旧版 std::function<void(void*)> 回调表与新版委托表 (函数指针 + ctx)
+// 用法: ./bus_bench [publish_count] [subscriber_count]
+#include "../src/event_bus.h"
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 旧版实现的原样拷贝，作为基线
+class LegacyBus {
+public:
+    using Handler = std::function<void(void*)>;
+
+    void subscribe(EventType type, Handler handler) {
+        if (type < 0 || type >= MAX_EVENTS) return;
+        handlers_[type].push_back(handler);
+    }
+
+    void publish(EventType type, void* data) {
+        if (type < 0 || type >= MAX_EVENTS) return;
+        for (auto& h : handlers_[type]) {
+            h(data);
+        }
+    }
+
+private:
+    std::array<std::vector<Handler>, MAX_EVENTS> handlers_;
+};
+
+// 模拟一个轻量的行情订阅者 (类似 StrategyModule::onTick 的阈值判断)
+struct TickSink {
+    double sum = 0;
+    uint64_t hits = 0;
+
+    void onTick(const TickRecord& tick) {
+        sum += tick.last_price;
+        if (tick.last_price > 3500.0) hits++;
+    }
+};
+
+// 批量订阅者：一次处理一段连续的 TickRecord
+struct BatchSink {
+    double sum = 0;
+    uint64_t hits = 0;
+
+    void onTicks(const TickRecord* ticks, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            sum += ticks[i].last_price;
+            if (ticks[i].last_price > 3500.0) hits++;
+        }
+    }
+};
+
+template <typename Fn>
+double measure_ns(uint64_t count, Fn&& fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < count; ++i) {
+        fn(i);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t count = 10000000;
+    int subscribers = 4;
+    if (argc > 1) count = std::stoull(argv[1]);
+    if (argc > 2) subscribers = std::stoi(argv[2]);
+
+    TickRecord tick;
+    std::memset(&tick, 0, sizeof(tick));
+    std::strncpy(tick.symbol, "au2606", sizeof(tick.symbol) - 1);
+
+    std::vector<TickSink> legacy_sinks(subscribers);
+    std::vector<TickSink> legacy_adapter_sinks(subscribers);
+    std::vector<TickSink> typed_sinks(subscribers);
+
+    LegacyBus legacy;
+    EventBusImpl adapted; // 新总线 + 旧式 std::function 订阅
+    EventBusImpl typed;   // 新总线 + 类型化委托订阅
+    EventBus* typed_bus = &typed; // 通过基类指针调用，和插件里的用法一致
+    EventBus* adapted_bus = &adapted;
+
+    for (int i = 0; i < subscribers; ++i) {
+        TickSink* s1 = &legacy_sinks[i];
+        legacy.subscribe(EVENT_MARKET_DATA, [s1](void* d) { s1->onTick(*static_cast<TickRecord*>(d)); });
+        TickSink* s2 = &legacy_adapter_sinks[i];
+        adapted_bus->subscribe(EVENT_MARKET_DATA, [s2](void* d) { s2->onTick(*static_cast<TickRecord*>(d)); });
+        typed_bus->subscribe<EVENT_MARKET_DATA, &TickSink::onTick>(&typed_sinks[i]);
+    }
+
+    // 预热
+    for (int i = 0; i < 100000; ++i) {
+        legacy.publish(EVENT_MARKET_DATA, &tick);
+        adapted_bus->publish(EVENT_MARKET_DATA, &tick);
+        typed_bus->publish<EVENT_MARKET_DATA>(tick);
+    }
+
+    double legacy_ns = measure_ns(count, [&](uint64_t i) {
+        tick.last_price = 3400.0 + (i & 255);
+        legacy.publish(EVENT_MARKET_DATA, &tick);
+    });
+    double adapted_ns = measure_ns(count, [&](uint64_t i) {
+        tick.last_price = 3400.0 + (i & 255);
+        adapted_bus->publish(EVENT_MARKET_DATA, &tick);
+    });
+    double typed_ns = measure_ns(count, [&](uint64_t i) {
+        tick.last_price = 3400.0 + (i & 255);
+        typed_bus->publish<EVENT_MARKET_DATA>(tick);
+    });
+
+    // 开启回调耗时统计后的类型化委托，衡量插桩本身的开销
+    std::vector<TickSink> timed_sinks(subscribers);
+    EventBusImpl timed;
+    timed.enable_latency_stats();
+    EventBus* timed_bus = &timed;
+    for (int i = 0; i < subscribers; ++i) {
+        timed_bus->subscribe<EVENT_MARKET_DATA, &TickSink::onTick>(&timed_sinks[i]);
+    }
+    double timed_ns = measure_ns(count, [&](uint64_t i) {
+        tick.last_price = 3400.0 + (i & 255);
+        timed_bus->publish<EVENT_MARKET_DATA>(tick);
+    });
+    auto timed_stats = timed_bus->latency_stats();
+
+    // 批量发布：每次 kBatch 条，分别投递给逐条订阅者与批量订阅者
+    const size_t kBatch = 64;
+    std::vector<TickRecord> block(kBatch, tick);
+    for (size_t i = 0; i < kBatch; ++i) block[i].last_price = 3400.0 + i * 4;
+
+    std::vector<TickSink> per_record_sinks(subscribers);
+    std::vector<BatchSink> batch_sinks(subscribers);
+    EventBusImpl per_record;
+    EventBusImpl batched;
+    EventBus* per_record_bus = &per_record;
+    EventBus* batched_bus = &batched;
+    for (int i = 0; i < subscribers; ++i) {
+        per_record_bus->subscribe<EVENT_MARKET_DATA, &TickSink::onTick>(&per_record_sinks[i]);
+        batched_bus->subscribe_batch<EVENT_MARKET_DATA, &BatchSink::onTicks>(&batch_sinks[i]);
+    }
+    const uint64_t blocks = count / kBatch;
+    double batch_record_ns = measure_ns(blocks, [&](uint64_t) {
+        per_record_bus->publish_batch<EVENT_MARKET_DATA>(block.data(), kBatch);
+    }) / kBatch;
+    double batch_batch_ns = measure_ns(blocks, [&](uint64_t) {
+        batched_bus->publish_batch<EVENT_MARKET_DATA>(block.data(), kBatch);
+    }) / kBatch;
+
+    // 防止编译器把订阅者消除
+    double checksum = 0;
+    for (int i = 0; i < subscribers; ++i) {
+        checksum += legacy_sinks[i].hits + legacy_adapter_sinks[i].hits + typed_sinks[i].hits;
+        checksum += per_record_sinks[i].hits + batch_sinks[i].hits + timed_sinks[i].hits;
+    }
+
+    std::cout << "EventBus publish benchmark: " << count << " publishes x "
+              << subscribers << " subscribers (checksum " << checksum << ")" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  legacy bus (std::function)  : " << std::setw(7) << legacy_ns << " ns/publish" << std::endl;
+    std::cout << "  delegate bus (std::function): " << std::setw(7) << adapted_ns << " ns/publish" << std::endl;
+    std::cout << "  delegate bus (typed)        : " << std::setw(7) << typed_ns << " ns/publish" << std::endl;
+    std::cout << "  delegate bus (typed, timed) : " << std::setw(7) << timed_ns << " ns/publish" << std::endl;
+    for (const auto& l : timed_stats) {
+        std::cout << "    handler p50/p99/p99.9/max : " << l.p50_ns << " / " << l.p99_ns << " / "
+                  << l.p999_ns << " / " << l.max_ns << " ns" << std::endl;
+    }
+    std::cout << "  publish_batch (per-record)  : " << std::setw(7) << batch_record_ns << " ns/tick" << std::endl;
+    std::cout << "  publish_batch (batch)       : " << std::setw(7) << batch_batch_ns << " ns/tick" << std::endl;
+    return 0;
+}
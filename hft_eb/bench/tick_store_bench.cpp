@@ -0,0 +1,169 @@
+// 列式行情载入与向量化内核基准
+// 对比按 TickRecord 逐条扫描 (AoS) 与 TickStore 列上的标量 / AVX2 内核
+// 用法: ./tick_store_bench <base_path>... [--threads N] [--window 条数]
+#include "protocol.h"
+#include "mmap_util.h"
+#include "tick_store.h"
+#include "tick_kernels.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// 基线：逐条读取 TickRecord，按合约名累计 VWAP
+std::unordered_map<std::string, double> aos_vwap(const std::vector<std::string>& paths) {
+    struct Acc {
+        double pv = 0, v = 0;
+        int32_t last_volume = 0;
+        bool seen = false;
+    };
+    std::unordered_map<std::string, Acc> acc;
+    for (const std::string& path : paths) {
+        for (auto& pair : acc) pair.second.seen = false; // 累计成交量按交易日重置
+        MmapReader<TickRecord> reader(path);
+        for (auto batch = reader.peek_batch(); !batch.empty(); batch = reader.peek_batch()) {
+            for (const TickRecord& rec : batch) {
+                Acc& a = acc[std::string(rec.symbol, strnlen(rec.symbol, sizeof(rec.symbol)))];
+                if (a.seen) {
+                    int32_t d = std::max(rec.volume - a.last_volume, 0);
+                    a.pv += rec.last_price * d;
+                    a.v += d;
+                }
+                a.last_volume = rec.volume;
+                a.seen = true;
+            }
+            reader.commit(batch.size);
+        }
+    }
+    std::unordered_map<std::string, double> out;
+    for (const auto& pair : acc) out[pair.first] = pair.second.v > 0 ? pair.second.pv / pair.second.v : NAN;
+    return out;
+}
+
+struct KernelTimes {
+    double vwap = 0, returns = 0, rolling = 0;
+    double checksum = 0;
+};
+
+KernelTimes run_kernels(const TickKernels& k, const TickStore& store, size_t window, int rounds) {
+    KernelTimes t;
+    std::vector<double> out;
+    for (int r = 0; r < rounds; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (const SymbolTicks& sym : store) {
+            for (const TickDay& day : sym.days) {
+                double v = k.vwap(sym.last_price + day.begin, sym.volume + day.begin, day.end - day.begin);
+                if (!std::isnan(v)) t.checksum += v;
+            }
+        }
+        t.vwap += seconds_since(t0);
+
+        t0 = std::chrono::steady_clock::now();
+        for (const SymbolTicks& sym : store) {
+            out.resize(sym.count);
+            k.returns(sym.last_price, out.data(), sym.count);
+            if (sym.count > 1) t.checksum += out[sym.count / 2];
+        }
+        t.returns += seconds_since(t0);
+
+        t0 = std::chrono::steady_clock::now();
+        for (const SymbolTicks& sym : store) {
+            out.resize(sym.count);
+            k.rolling_max(sym.last_price, out.data(), sym.count, window);
+            if (sym.count > 0) t.checksum += out[sym.count - 1];
+            k.rolling_min(sym.last_price, out.data(), sym.count, window);
+            if (sym.count > 0) t.checksum += out[sym.count - 1];
+        }
+        t.rolling += seconds_since(t0);
+    }
+    t.vwap /= rounds;
+    t.returns /= rounds;
+    t.rolling /= rounds;
+    return t;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> paths;
+    unsigned threads = 0;
+    size_t window = 120;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::stoul(argv[++i]);
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window = std::stoul(argv[++i]);
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <base_path>... [--threads N] [--window ticks]" << std::endl;
+        return 1;
+    }
+
+    try {
+        auto t0 = std::chrono::steady_clock::now();
+        TickStore store(paths, threads);
+        double build_sec = seconds_since(t0);
+        const double raw_bytes = static_cast<double>(store.record_count()) * sizeof(TickRecord);
+
+        t0 = std::chrono::steady_clock::now();
+        auto aos = aos_vwap(paths);
+        double aos_sec = seconds_since(t0);
+
+        const int rounds = 5;
+        KernelTimes scalar = run_kernels(tick_kernels_scalar(), store, window, rounds);
+        bool has_avx2 = __builtin_cpu_supports("avx2");
+        KernelTimes avx2 = has_avx2 ? run_kernels(tick_kernels_avx2(), store, window, rounds) : KernelTimes{};
+
+        // 结果校验：只有一个交易日的合约，AoS 基线与列式 VWAP 应一致 (累加顺序不同，允许末位差异)
+        double max_rel = 0;
+        for (const SymbolTicks& sym : store) {
+            if (sym.days.size() != 1) continue;
+            double a = aos[sym.symbol];
+            double b = tick_kernels().vwap(sym.last_price, sym.volume, sym.count);
+            if (!std::isnan(a) && !std::isnan(b)) max_rel = std::max(max_rel, std::fabs(a - b) / std::fabs(a));
+        }
+
+        // 每个内核实际读取的列字节数
+        const double n = static_cast<double>(store.record_count());
+        const double vwap_bytes = n * (sizeof(double) + sizeof(int32_t));
+        const double price_bytes = n * sizeof(double);
+
+        std::cout << "TickStore benchmark: " << store.record_count() << " ticks, " << store.size() << " symbols, "
+                  << paths.size() << " journal(s), kernels: " << tick_kernels().name << std::endl;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "  build (SoA, " << (threads ? threads : std::thread::hardware_concurrency()) << " threads) : "
+                  << std::setw(8) << build_sec << " s  (" << raw_bytes / build_sec / 1e9 << " GB/s of TickRecord, "
+                  << store.bytes() / 1e6 << " MB columns)" << std::endl;
+        std::cout << "  VWAP, AoS scan                : " << std::setw(8) << aos_sec * 1e3 << " ms  ("
+                  << raw_bytes / aos_sec / 1e9 << " GB/s of TickRecord)" << std::endl;
+        auto line = [&](const char* name, double sec, double bytes) {
+            std::cout << "  " << name << std::setw(8) << sec * 1e3 << " ms  (" << bytes / sec / 1e9 << " GB/s)" << std::endl;
+        };
+        line("VWAP, SoA scalar              : ", scalar.vwap, vwap_bytes);
+        if (has_avx2) line("VWAP, SoA AVX2                : ", avx2.vwap, vwap_bytes);
+        line("returns, SoA scalar           : ", scalar.returns, 2 * price_bytes);
+        if (has_avx2) line("returns, SoA AVX2             : ", avx2.returns, 2 * price_bytes);
+        line("rolling max+min, SoA scalar   : ", scalar.rolling, 4 * price_bytes);
+        if (has_avx2) line("rolling max+min, SoA AVX2     : ", avx2.rolling, 4 * price_bytes);
+        std::cout << std::setprecision(2) << "  checksum scalar / avx2        : " << scalar.checksum << " / " << avx2.checksum
+                  << std::endl;
+        std::cout << std::scientific << "  max VWAP rel. diff vs AoS     : " << max_rel << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
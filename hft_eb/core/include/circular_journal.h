@@ -0,0 +1,405 @@
+#pragma once
+#include "mmap_util.h"
+#include <sys/mman.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cerrno>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------
+// 定长循环日志：录制器 -> 引擎的盘中 IPC，占用内存固定，与当天行情量无关
+// 文件布局: <base>.meta (MetaHeader，flags 含 JOURNAL_FLAG_CIRCULAR)
+//           <base>.dat  (capacity 条记录的环，capacity 为 2 的幂，第 n 条位于 n & (capacity - 1))
+//           <base>.rdr  (ReaderRegistry，读者在此登记各自的消费游标)
+// write_cursor 仍是单调递增的逻辑序号；写者只在写到 "最慢读者 + capacity" 时才重新扫描读者表，
+// 追上最慢读者 (套圈) 时按 LapPolicy 处理。读者通过游标差自行检测是否被套圈，不依赖写者通知。
+// ---------------------------------------------------------
+enum class LapPolicy : uint32_t {
+    Block = 0,   // 等待最慢的读者 (已退出进程的读者会被回收)，不丢数据，慢读者会拖慢录制
+    Drop = 1,    // 丢弃新记录 (同样回收已退出的读者)，已登记的读者不丢数据，write() 返回 false
+    Overrun = 2, // 直接覆盖，被套圈的读者跳到最新位置并记录丢失条数
+};
+
+inline const char* lap_policy_name(LapPolicy policy) {
+    switch (policy) {
+    case LapPolicy::Block: return "block";
+    case LapPolicy::Drop: return "drop";
+    case LapPolicy::Overrun: return "overrun";
+    }
+    return "unknown";
+}
+
+// 解析配置中的策略名，未知名称返回 false
+inline bool parse_lap_policy(const std::string& name, LapPolicy& out) {
+    if (name == "block") {
+        out = LapPolicy::Block;
+    } else if (name == "drop") {
+        out = LapPolicy::Drop;
+    } else if (name == "overrun") {
+        out = LapPolicy::Overrun;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static constexpr uint32_t READER_FREE = 0;
+static constexpr uint32_t READER_CLAIMING = 1; // 正在登记，写者忽略
+static constexpr uint32_t READER_ACTIVE = 2;
+
+// 每个读者独占一个缓存行，游标只由读者自己写，写者只读
+struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> cursor;   // 已消费到的逻辑序号
+    std::atomic<uint32_t> state;    // READER_*
+    int32_t pid;                    // 读者进程，Block 策略下用于回收已退出的读者
+    std::atomic<uint64_t> overruns; // 被套圈的次数
+    std::atomic<uint64_t> lost;     // 因套圈跳过的记录数
+    char name[24];
+    char pad[8];
+};
+static_assert(sizeof(ReaderSlot) == 64, "ReaderSlot must stay one cache line");
+
+static constexpr uint32_t CIRCULAR_MAX_READERS = 63;
+
+struct ReaderRegistry {
+    std::atomic<uint64_t> dropped;      // Drop 策略下丢弃的记录数
+    std::atomic<uint64_t> blocked;      // Block 策略下写者等待读者的次数
+    std::atomic<uint32_t> policy;       // 当前写者的 LapPolicy
+    std::atomic<uint32_t> high_water;   // 用过的槽位上界，写者只扫描 [0, high_water)
+    char pad[64 - 24];
+    ReaderSlot slots[CIRCULAR_MAX_READERS];
+};
+static_assert(sizeof(ReaderRegistry) == 4096, "ReaderRegistry must stay 4KB");
+
+inline std::string circular_registry_path(const std::string& base_path) { return base_path + ".rdr"; }
+
+// 读者表由写者或第一个读者创建；ftruncate 到相同大小不会改动已有内容，并发创建是安全的
+inline ReaderRegistry* circular_map_registry(const std::string& base_path) {
+    return static_cast<ReaderRegistry*>(
+        mmap_file(circular_registry_path(base_path), sizeof(ReaderRegistry), true, true));
+}
+
+inline bool circular_reader_alive(const ReaderSlot& slot) {
+    return slot.pid <= 0 || kill(slot.pid, 0) == 0 || errno != ESRCH;
+}
+
+// 回收已退出进程留下的读者槽位，返回回收的个数
+inline uint32_t circular_reap_readers(ReaderRegistry* registry, const std::string& base_path) {
+    uint32_t reaped = 0;
+    uint32_t high = std::min(registry->high_water.load(), CIRCULAR_MAX_READERS);
+    for (uint32_t i = 0; i < high; ++i) {
+        ReaderSlot& slot = registry->slots[i];
+        uint32_t state = READER_ACTIVE;
+        if (slot.state.load() != READER_ACTIVE || circular_reader_alive(slot)) continue;
+        if (slot.state.compare_exchange_strong(state, READER_FREE)) {
+            std::cerr << "[Circular] 回收已退出的读者 " << slot.name << " (pid " << slot.pid << "): " << base_path
+                      << std::endl;
+            reaped++;
+        }
+    }
+    return reaped;
+}
+
+// ---------------------------------------------------------
+// 循环日志写入器 (单生产者)
+// 热路径与 MmapWriter 相同：写记录、发布游标、按需唤醒；只有写到 limit_ (上次扫描时最慢读者 + capacity)
+// 才扫描读者表，读者跟得上时每写约 capacity 条才扫描一次。
+// 已有文件时沿用文件中的容量与游标，已登记的读者继续有效。
+// ---------------------------------------------------------
+template <typename T>
+class CircularWriter {
+public:
+    // capacity: 环的容量 (条数)，向上取整为 2 的幂
+    CircularWriter(const std::string& base_path, uint64_t capacity, LapPolicy lap_policy = LapPolicy::Block,
+                   const MemoryPolicy& policy = MemoryPolicy{})
+        : base_path_(base_path), lap_policy_(lap_policy) {
+        meta_ptr_ = mmap_meta_for_write(base_path);
+
+        std::string error;
+        if (meta_ptr_->capacity == 0) {
+            uint64_t rounded = 1;
+            while (rounded < capacity) rounded <<= 1;
+            meta_ptr_->capacity = rounded;
+            meta_ptr_->write_cursor = 0;
+            meta_ptr_->segments = 1;
+            meta_ptr_->flags = JOURNAL_FLAG_CIRCULAR;
+            journal_stamp_layout<T>(meta_ptr_);
+        } else if (!(meta_ptr_->flags & JOURNAL_FLAG_CIRCULAR)) {
+            error = "按天日志不能作为循环日志续写: " + base_path;
+        } else {
+            std::string reason = journal_layout_mismatch<T>(meta_ptr_);
+            if (!reason.empty()) error = journal_layout_error(reason, base_path).what();
+        }
+        if (!error.empty()) {
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            throw std::runtime_error(error);
+        }
+        capacity_ = meta_ptr_->capacity;
+        mask_ = capacity_ - 1;
+
+        try {
+            data_ = static_cast<T*>(mmap_file(mmap_segment_path(base_path, 0), capacity_ * sizeof(T), true, true, policy));
+            registry_ = circular_map_registry(base_path);
+        } catch (...) {
+            if (data_) munmap(data_, capacity_ * sizeof(T));
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            throw;
+        }
+        registry_->policy.store(static_cast<uint32_t>(lap_policy_));
+    }
+
+    ~CircularWriter() {
+        if (data_) munmap(data_, capacity_ * sizeof(T));
+        if (registry_) munmap(registry_, sizeof(ReaderRegistry));
+        if (meta_ptr_) munmap(meta_ptr_, sizeof(MetaHeader));
+    }
+
+    CircularWriter(const CircularWriter&) = delete;
+    CircularWriter& operator=(const CircularWriter&) = delete;
+
+    // 返回 false 表示按 Drop 策略丢弃了本条
+    bool write(const T& record) {
+        uint64_t cursor = meta_ptr_->write_cursor.load(std::memory_order_relaxed);
+        if (cursor >= limit_ && !make_room(cursor)) return false;
+
+        data_[cursor & mask_] = record;
+        std::atomic_thread_fence(std::memory_order_release);
+        meta_ptr_->write_cursor.fetch_add(1, std::memory_order_seq_cst);
+
+        if (meta_ptr_->waiters.load(std::memory_order_seq_cst) != 0) mmap_wake_readers(meta_ptr_);
+        return true;
+    }
+
+    // 当前最慢读者的游标 (没有读者时为 write_cursor)
+    uint64_t slowest_reader() const { return scan_readers(meta_ptr_->write_cursor.load(), false); }
+
+    uint64_t capacity() const { return capacity_; }
+    uint64_t dropped() const { return registry_->dropped.load(std::memory_order_relaxed); }
+
+private:
+    // 扫描已登记的读者，返回最慢读者的游标；skip_lapped 时忽略已被套圈 (其下一条即将或已被覆盖) 的读者
+    uint64_t scan_readers(uint64_t cursor, bool skip_lapped) const {
+        uint64_t slowest = cursor;
+        uint32_t high = std::min(registry_->high_water.load(std::memory_order_seq_cst), CIRCULAR_MAX_READERS);
+        for (uint32_t i = 0; i < high; ++i) {
+            const ReaderSlot& slot = registry_->slots[i];
+            if (slot.state.load(std::memory_order_seq_cst) != READER_ACTIVE) continue;
+            uint64_t c = slot.cursor.load(std::memory_order_acquire);
+            if (skip_lapped && c + capacity_ <= cursor) continue;
+            slowest = std::min(slowest, c);
+        }
+        return slowest;
+    }
+
+    // 写到 limit_ 时重新扫描读者；仍然写满则按 LapPolicy 处理
+    bool make_room(uint64_t cursor) {
+        limit_ = scan_readers(cursor, lap_policy_ == LapPolicy::Overrun) + capacity_;
+        if (cursor < limit_) return true;
+
+        // Overrun 忽略了已被套圈的读者，总能写入；走到这里只可能是 Drop 或 Block
+        if (lap_policy_ == LapPolicy::Drop) {
+            // 持续丢弃时定期回收已退出的读者，避免崩溃的读者让后续记录全部被丢弃
+            if (registry_->dropped.fetch_add(1, std::memory_order_relaxed) % 1024 == 1023) {
+                circular_reap_readers(registry_, base_path_);
+            }
+            return false;
+        }
+
+        // Block: 先自旋，再让出 CPU，最后短睡眠；定期回收已退出的读者，避免崩溃的读者永久卡住录制
+        registry_->blocked.fetch_add(1, std::memory_order_relaxed);
+        for (uint32_t spins = 1;; ++spins) {
+            if (spins < 1024) {
+                _mm_pause();
+            } else if (spins < 1024 + 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                if (spins % 1024 == 0) circular_reap_readers(registry_, base_path_);
+            }
+            limit_ = scan_readers(cursor, false) + capacity_;
+            if (cursor < limit_) return true;
+        }
+    }
+
+    std::string base_path_;
+    LapPolicy lap_policy_;
+    uint64_t capacity_ = 0;
+    uint64_t mask_ = 0;
+    uint64_t limit_ = 0; // 写到此序号前无需扫描读者
+    T* data_ = nullptr;
+    ReaderRegistry* registry_ = nullptr;
+    MetaHeader* meta_ptr_ = nullptr;
+};
+
+// ---------------------------------------------------------
+// 循环日志读取器：构造时在读者表中登记 (从最新位置开始消费)，析构时注销。
+// 接口与 MmapReader 一致 (peek_batch / commit / read / wait)；commit 时发布游标供写者判断最慢读者。
+// 被套圈时跳到最新位置，并在自己的槽位上累计 overruns / lost。
+// Overrun 策略下 peek_batch 返回的视图可能在处理过程中被覆盖，commit 返回 false 表示该批可能已损坏；
+// read() 先拷贝再校验，只返回完整的记录。Block / Drop 策略下数据在 commit 前不会被覆盖。
+// ---------------------------------------------------------
+template <typename T>
+class CircularReader {
+public:
+    CircularReader(const std::string& base_path, const std::string& name = "reader",
+                   WaitPolicy policy = WaitPolicy::Spin, uint32_t spin_count = 4096,
+                   const MemoryPolicy& memory = MemoryPolicy{})
+        : base_path_(base_path), policy_(policy), spin_count_(spin_count) {
+        meta_ptr_ = mmap_meta_for_read(base_path, policy_);
+
+        capacity_ = meta_ptr_->capacity;
+        std::string error;
+        if (capacity_ == 0) {
+            error = "元数据未初始化: " + base_path + ".meta";
+        } else if (!(meta_ptr_->flags & JOURNAL_FLAG_CIRCULAR)) {
+            error = "不是循环日志，请用 MmapReader 读取: " + base_path;
+        } else {
+            std::string reason = journal_layout_mismatch<T>(meta_ptr_);
+            if (!reason.empty()) error = journal_layout_error(reason, base_path).what();
+        }
+        if (!error.empty()) {
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            throw std::runtime_error(error);
+        }
+        mask_ = capacity_ - 1;
+
+        try {
+            data_ = static_cast<T*>(
+                mmap_file(mmap_segment_path(base_path, 0), capacity_ * sizeof(T), false, false, memory));
+            registry_ = circular_map_registry(base_path);
+            attach(name);
+        } catch (...) {
+            if (data_) munmap(const_cast<T*>(data_), capacity_ * sizeof(T));
+            if (registry_) munmap(registry_, sizeof(ReaderRegistry));
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            throw;
+        }
+    }
+
+    ~CircularReader() {
+        slot_->state.store(READER_FREE, std::memory_order_release);
+        munmap(const_cast<T*>(data_), capacity_ * sizeof(T));
+        munmap(registry_, sizeof(ReaderRegistry));
+        munmap(meta_ptr_, sizeof(MetaHeader));
+    }
+
+    CircularReader(const CircularReader&) = delete;
+    CircularReader& operator=(const CircularReader&) = delete;
+
+    // 零拷贝批量读取：返回当前已就绪的连续记录 (最多 max_count 条，不跨过环的末尾)
+    RecordSpan<T> peek_batch(size_t max_count = SIZE_MAX) {
+        uint64_t w_cursor = meta_ptr_->write_cursor.load(std::memory_order_acquire);
+        if (local_cursor_ >= w_cursor) return {};
+        if (w_cursor - local_cursor_ > capacity_) {
+            resync(local_cursor_, w_cursor);
+            return {};
+        }
+
+        uint64_t offset = local_cursor_ & mask_;
+        uint64_t n = std::min<uint64_t>(w_cursor - local_cursor_, capacity_ - offset);
+        if (n > max_count) n = max_count;
+        return {data_ + offset, static_cast<size_t>(n)};
+    }
+
+    // 确认已处理 peek_batch 返回的前 n 条并发布游标；返回 false 表示处理期间已被写者覆盖 (仅 Overrun 策略)
+    bool commit(size_t n) {
+        uint64_t start = local_cursor_;
+        local_cursor_ += n;
+        if (may_overrun()) {
+            // 写者正在写第 w 条时会覆盖第 w - capacity 条：只要 w 还没到 start + capacity，本批就是完整的。
+            // Block / Drop 策略下写者最多停在 start + capacity，不会覆盖
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t w_cursor = meta_ptr_->write_cursor.load(std::memory_order_relaxed);
+            if (w_cursor >= start + capacity_) {
+                resync(start, w_cursor);
+                return false;
+            }
+        }
+        slot_->cursor.store(local_cursor_, std::memory_order_release);
+        return true;
+    }
+
+    bool read(T& out_record) {
+        for (;;) {
+            RecordSpan<T> batch = peek_batch(1);
+            if (batch.empty()) return false;
+            out_record = batch.data[0];
+            if (commit(1)) return true;
+        }
+    }
+
+    bool available() const {
+        return local_cursor_ < meta_ptr_->write_cursor.load(std::memory_order_acquire);
+    }
+
+    bool wait(std::chrono::microseconds timeout) {
+        return mmap_wait(meta_ptr_, policy_, spin_count_, timeout, [this] { return available(); });
+    }
+
+    uint64_t position() const { return local_cursor_; }
+    uint64_t capacity() const { return capacity_; }
+    // 写者是否可能覆盖未确认的记录 (Overrun 策略)；此时零拷贝处理前应先拷贝出来，commit 成功后再使用
+    bool may_overrun() const {
+        return registry_->policy.load(std::memory_order_relaxed) == static_cast<uint32_t>(LapPolicy::Overrun);
+    }
+    uint64_t overruns() const { return slot_->overruns.load(std::memory_order_relaxed); }
+    uint64_t lost() const { return slot_->lost.load(std::memory_order_relaxed); }
+
+private:
+    // 登记顺序保证写者不会覆盖本读者需要的记录：先抬高 high_water、再置 ACTIVE，最后重读 write_cursor 作为起点。
+    // 写者的扫描若没看到 ACTIVE，则其游标先于我们重读的 write_cursor，它据此算出的 limit 不会越过我们的起点
+    void attach(const std::string& name) {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            for (uint32_t i = 0; i < CIRCULAR_MAX_READERS; ++i) {
+                ReaderSlot& slot = registry_->slots[i];
+                uint32_t state = READER_FREE;
+                if (!slot.state.compare_exchange_strong(state, READER_CLAIMING)) continue;
+
+                uint32_t high = registry_->high_water.load();
+                while (high < i + 1 && !registry_->high_water.compare_exchange_weak(high, i + 1)) {
+                }
+                slot.pid = getpid();
+                memset(slot.name, 0, sizeof(slot.name));
+                strncpy(slot.name, name.c_str(), sizeof(slot.name) - 1);
+                slot.overruns.store(0);
+                slot.lost.store(0);
+                slot.cursor.store(meta_ptr_->write_cursor.load());
+                slot.state.store(READER_ACTIVE);
+
+                local_cursor_ = meta_ptr_->write_cursor.load();
+                slot.cursor.store(local_cursor_);
+                slot_ = &slot;
+                return;
+            }
+            // 槽位用完：回收已退出进程的读者后重试一次
+            if (circular_reap_readers(registry_, base_path_) == 0) break;
+        }
+        throw std::runtime_error("循环日志读者已满 (" + std::to_string(CIRCULAR_MAX_READERS) + "): " + base_path_);
+    }
+
+    // 被套圈：跳到最新位置，记录丢失的条数
+    void resync(uint64_t from, uint64_t w_cursor) {
+        slot_->overruns.fetch_add(1, std::memory_order_relaxed);
+        slot_->lost.fetch_add(w_cursor - from, std::memory_order_relaxed);
+        local_cursor_ = w_cursor;
+        slot_->cursor.store(local_cursor_, std::memory_order_release);
+    }
+
+    std::string base_path_;
+    WaitPolicy policy_;
+    uint32_t spin_count_;
+    uint64_t capacity_ = 0;
+    uint64_t mask_ = 0;
+    const T* data_ = nullptr;
+    ReaderRegistry* registry_ = nullptr;
+    ReaderSlot* slot_ = nullptr;
+    MetaHeader* meta_ptr_ = nullptr;
+    uint64_t local_cursor_ = 0;
+};
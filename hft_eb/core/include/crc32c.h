@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <nmmintrin.h> // _mm_crc32_u64
+
+// ---------------------------------------------------------
+// CRC32C (Castagnoli)：支持 SSE4.2 时使用 crc32 指令 (每 8 字节约 1 cycle 吞吐)，否则查表
+// ---------------------------------------------------------
+namespace crc32c_detail {
+
+__attribute__((target("sse4.2")))
+inline uint32_t hw(uint32_t crc, const unsigned char* p, size_t len) {
+    uint64_t c = crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        c = _mm_crc32_u64(c, v);
+    }
+    uint32_t c32 = static_cast<uint32_t>(c);
+    for (; len > 0; ++p, --len) c32 = _mm_crc32_u8(c32, *p);
+    return c32;
+}
+
+inline uint32_t sw(uint32_t crc, const unsigned char* p, size_t len) {
+    static const auto table = [] {
+        struct Table { uint32_t v[256]; } t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            t.v[i] = c;
+        }
+        return t;
+    }();
+    for (; len > 0; ++p, --len) crc = table.v[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+} // namespace crc32c_detail
+
+inline uint32_t crc32c(const void* data, size_t len, uint32_t seed = 0) {
+    static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint32_t crc = ~seed;
+    crc = has_sse42 ? crc32c_detail::hw(crc, p, len) : crc32c_detail::sw(crc, p, len);
+    return ~crc;
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include "protocol.h"
+#include "record_layout.h"
+#include "instrument_table.h"
+#include "trading_calendar.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// ---------------------------------------------------------
+// 紧凑热路径行情 HotTick (128 字节，两个缓存行)
+// - 合约用整数 ID 表示，名称与盘中不变的字段 (涨跌停、昨收、开盘价) 放在旁路的 InstrumentTable 中 (instrument_table.h)
+// - 价格为 int32 定点数，小数位数按合约价位选择 (InstrumentStatic::price_decimals)
+// - 五档按档位交错存放 (买价、买量、卖价、卖量)，第一档与成交价同在第一个缓存行
+// - 时间为交易所与本地接收两个 epoch 纳秒时间戳，交易日由交易日历从 exchange_time 推出，不再单独存放
+// to_hot_tick / to_tick_record 在两种格式间转换，按天日志、归档与总线仍使用 TickRecord
+// ---------------------------------------------------------
+static constexpr int32_t HOT_PRICE_NONE = INT32_MIN; // 无效价格 (CTP 以 DBL_MAX 表示)
+
+struct BookLevel {
+    int32_t bid_price;
+    int32_t bid_volume;
+    int32_t ask_price;
+    int32_t ask_volume;
+};
+
+struct alignas(64) HotTick {
+    uint32_t instrument_id;  // InstrumentTable 中的 ID
+    int volume;
+    int64_t exchange_time;   // 交易所时间 (epoch ns)
+    int64_t local_time;      // 本地接收时间 (epoch ns)
+    double turnover;
+    int32_t last_price;      // 定点价格
+    int32_t open_interest;   // 持仓量 (手)
+    int32_t highest_price;
+    int32_t lowest_price;
+    BookLevel levels[5];     // levels[0] 位于第一个缓存行
+};
+static_assert(sizeof(HotTick) == 128, "HotTick must stay two cache lines");
+static_assert(offsetof(HotTick, levels) + sizeof(BookLevel) <= 64, "L1 must stay in the first cache line");
+
+template <>
+struct RecordLayout<HotTick> {
+    static constexpr const char* name = "HotTick";
+    static constexpr FieldDesc fields[] = {
+        RECORD_FIELD(HotTick, instrument_id), RECORD_FIELD(HotTick, volume),
+        RECORD_FIELD(HotTick, exchange_time), RECORD_FIELD(HotTick, local_time),
+        RECORD_FIELD(HotTick, turnover),      RECORD_FIELD(HotTick, last_price),
+        RECORD_FIELD(HotTick, open_interest), RECORD_FIELD(HotTick, highest_price),
+        RECORD_FIELD(HotTick, lowest_price),  RECORD_FIELD(HotTick, levels),
+    };
+    static constexpr uint64_t hash = layout_hash(fields, sizeof(HotTick));
+};
+
+// 超出范围的价格 (含 DBL_MAX、NaN) 记为 HOT_PRICE_NONE
+inline int32_t to_fixed_price(double price, double scale) {
+    double scaled = price * scale;
+    if (!(std::fabs(scaled) < INT32_MAX)) return HOT_PRICE_NONE;
+    return static_cast<int32_t>(std::llround(scaled));
+}
+
+// 整数除以 10^n 的结果正好是最接近该十进制价格的 double，与交易所下发的价格逐位相同
+inline double from_fixed_price(int32_t price, double scale) {
+    return price == HOT_PRICE_NONE ? DBL_MAX : price / scale;
+}
+
+// 小数位数的参考价：依次取涨停价、昨收、最新价
+inline double hot_tick_ref_price(const TickRecord& rec) {
+    double ref = rec.upper_limit;
+    if (!(ref > 0 && ref < DBL_MAX)) ref = rec.pre_close_price;
+    if (!(ref > 0 && ref < DBL_MAX)) ref = rec.last_price;
+    return ref;
+}
+
+// 已登记 (或预登记) 的合约只转换热字段：不持锁、不抛异常，可在柜台行情回调线程调用。
+// 静态字段不写入旁路表，由调用方按到达顺序传递 (见 Recorder)
+inline void to_hot_tick(const TickRecord& rec, uint32_t id, InstrumentTable& table, HotTick& out) {
+    double scale = table.price_scale(id, hot_tick_ref_price(rec));
+    out.instrument_id = id;
+    out.volume = rec.volume;
+    out.exchange_time = rec.exchange_time;
+    out.local_time = rec.local_time;
+    out.turnover = rec.turnover;
+    out.last_price = to_fixed_price(rec.last_price, scale);
+    out.open_interest = static_cast<int32_t>(std::llround(std::min<double>(std::max(rec.open_interest, 0.0), INT32_MAX)));
+    out.highest_price = to_fixed_price(rec.highest_price, scale);
+    out.lowest_price = to_fixed_price(rec.lowest_price, scale);
+    for (int i = 0; i < 5; ++i) {
+        out.levels[i].bid_price = to_fixed_price(rec.bid_price[i], scale);
+        out.levels[i].bid_volume = rec.bid_volume[i];
+        out.levels[i].ask_price = to_fixed_price(rec.ask_price[i], scale);
+        out.levels[i].ask_volume = rec.ask_volume[i];
+    }
+}
+
+// 登记合约、更新静态字段，再转换热字段 (工具与离线转换使用，表已满时抛出异常)
+inline void to_hot_tick(const TickRecord& rec, InstrumentTable& table, HotTick& out) {
+    uint32_t id = table.intern(rec.symbol, hot_tick_ref_price(rec));
+    table.update_statics(id, InstrumentStatics{rec.upper_limit, rec.lower_limit, rec.open_price, rec.pre_close_price});
+    to_hot_tick(rec, id, table, out);
+}
+
+// 兼容层：从旁路表补齐合约名，静态字段取调用方给出的值 (行情到达时的版本)，还原为 TickRecord
+// (价格为合约小数位数内的十进制值时逐位一致)
+inline void to_tick_record(const HotTick& hot, const InstrumentTable& table, const InstrumentStatics& s,
+                           TickRecord& out) {
+    const InstrumentStatic& entry = table.at(hot.instrument_id);
+    double scale = table.price_scale(hot.instrument_id);
+
+    memset(&out, 0, sizeof(TickRecord));
+    memcpy(out.symbol, entry.symbol, sizeof(out.symbol));
+    out.instrument_id = hot.instrument_id;
+    out.trading_day = trading_day_of(hot.exchange_time);
+    out.exchange_time = hot.exchange_time;
+    out.local_time = hot.local_time;
+    out.last_price = from_fixed_price(hot.last_price, scale);
+    out.volume = hot.volume;
+    out.turnover = hot.turnover;
+    out.open_interest = hot.open_interest;
+    out.upper_limit = s.upper_limit;
+    out.lower_limit = s.lower_limit;
+    out.open_price = s.open_price;
+    out.highest_price = from_fixed_price(hot.highest_price, scale);
+    out.lowest_price = from_fixed_price(hot.lowest_price, scale);
+    out.pre_close_price = s.pre_close_price;
+    for (int i = 0; i < 5; ++i) {
+        out.bid_price[i] = from_fixed_price(hot.levels[i].bid_price, scale);
+        out.bid_volume[i] = hot.levels[i].bid_volume;
+        out.ask_price[i] = from_fixed_price(hot.levels[i].ask_price, scale);
+        out.ask_volume[i] = hot.levels[i].ask_volume;
+    }
+}
+
+// 静态字段取旁路表的当前值
+inline void to_tick_record(const HotTick& hot, const InstrumentTable& table, TickRecord& out) {
+    to_tick_record(hot, table, table.statics(hot.instrument_id), out);
+}
@@ -0,0 +1,376 @@
+#pragma once
+#include "mmap_util.h"
+#include <atomic>
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <signal.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+// ---------------------------------------------------------
+// 合约表：合约名 -> 稠密 ID (从 1 开始，0 表示未登记)，以及每个合约的静态信息
+// 共享表放在 /dev/shm 下，由录制器创建并登记合约 (多个录制进程可共用，登记时持有进程间锁)，
+// 引擎与工具只读打开。行情记录与总线事件携带 instrument_id，按合约的状态直接用 ID 作数组下标。
+// ID 在共享表文件存在期间保持不变；删除文件 (所有进程退出后) 即重新编号，已有日志中的 ID 随之失效
+// ---------------------------------------------------------
+static constexpr uint32_t INSTRUMENT_NONE = 0;
+static constexpr uint32_t INSTRUMENT_CAPACITY = 4096; // 含保留的 ID 0
+static constexpr uint32_t INSTRUMENT_MAX_DECIMALS = 4;
+static constexpr uint32_t INSTRUMENT_DECIMALS_UNSET = UINT32_MAX; // 预登记 (reserve) 的合约在首笔行情时才选定小数位数
+static constexpr uint32_t INSTRUMENT_TABLE_MAGIC = 0x54534E49; // "INST"
+static constexpr uint32_t INSTRUMENT_TABLE_VERSION = 1;
+static constexpr const char* INSTRUMENT_TABLE_DEFAULT_PATH = "/dev/shm/hft_instruments";
+
+// 合约静态信息。静态字段极少变化 (首笔行情、开盘)，用顺序锁更新：seq 为奇数表示正在写，读者重试
+struct alignas(64) InstrumentStatic {
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> price_decimals; // 定点价格的小数位数，选定后不变 (INSTRUMENT_DECIMALS_UNSET 表示尚未选定)
+    double price_scale;                   // 10^price_decimals，以 price_decimals 为准
+    char symbol[32];
+    double upper_limit;
+    double lower_limit;
+    double open_price;
+    double pre_close_price;
+};
+
+// 顺序锁读出的静态字段快照
+struct InstrumentStatics {
+    double upper_limit = 0;
+    double lower_limit = 0;
+    double open_price = 0;
+    double pre_close_price = 0;
+
+    bool operator==(const InstrumentStatics& o) const {
+        return upper_limit == o.upper_limit && lower_limit == o.lower_limit && open_price == o.open_price &&
+               pre_close_price == o.pre_close_price;
+    }
+    bool operator!=(const InstrumentStatics& o) const { return !(*this == o); }
+};
+
+struct alignas(64) InstrumentTableHeader {
+    std::atomic<uint32_t> magic;  // INSTRUMENT_TABLE_MAGIC，最后写入
+    uint32_t version;
+    uint32_t capacity;
+    std::atomic<uint32_t> count;  // 下一个待分配的 ID
+    std::atomic<int32_t> lock;    // 登记锁，值为持有者 pid，0 表示空闲
+};
+
+// 映射到文件 (或匿名内存) 的整张表
+struct InstrumentTableData {
+    InstrumentTableHeader header;
+    InstrumentStatic entries[INSTRUMENT_CAPACITY];              // 下标即 ID
+    std::atomic<uint32_t> slots[INSTRUMENT_CAPACITY * 2];       // 开放寻址，值为 ID，0 表示空
+};
+
+// 选择小数位数：参考价的两倍仍不超出 int32 的最大位数 (参考价无效时取最大位数)
+inline uint32_t instrument_price_decimals(double ref_price) {
+    double bound = std::fabs(ref_price) * 2;
+    if (!(bound > 0) || bound >= DBL_MAX) return INSTRUMENT_MAX_DECIMALS;
+    uint32_t decimals = INSTRUMENT_MAX_DECIMALS;
+    double scale = 1e4;
+    while (decimals > 0 && bound * scale >= INT32_MAX) {
+        decimals--;
+        scale /= 10;
+    }
+    return decimals;
+}
+
+inline double instrument_price_scale(uint32_t decimals) {
+    static constexpr double kScale[INSTRUMENT_MAX_DECIMALS + 1] = {1, 10, 100, 1000, 10000};
+    return decimals <= INSTRUMENT_MAX_DECIMALS ? kScale[decimals] : 0;
+}
+
+class InstrumentTable {
+public:
+    static constexpr uint32_t kCapacity = INSTRUMENT_CAPACITY;
+
+    // 进程私有表 (匿名映射)
+    InstrumentTable() {
+        void* p = mmap(nullptr, sizeof(InstrumentTableData), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::runtime_error("合约表内存分配失败");
+        data_ = static_cast<InstrumentTableData*>(p);
+        init_header();
+    }
+
+    // 共享表：writable 时不存在则创建 (录制器)，否则只读打开已有的表 (引擎、工具)
+    InstrumentTable(const std::string& path, bool writable) : writable_(writable), shared_(true) {
+        struct stat st;
+        bool exists = stat(path.c_str(), &st) == 0;
+        if (exists && static_cast<size_t>(st.st_size) != sizeof(InstrumentTableData)) {
+            throw std::runtime_error("合约表大小不匹配: " + path);
+        }
+        if (!exists && !writable) throw std::runtime_error("合约表不存在: " + path);
+        data_ = static_cast<InstrumentTableData*>(mmap_file(path, sizeof(InstrumentTableData), writable, writable));
+
+        InstrumentTableHeader& h = data_->header;
+        if (writable && h.magic.load(std::memory_order_acquire) == 0) {
+            lock();
+            if (h.magic.load(std::memory_order_relaxed) == 0) init_header();
+            unlock();
+        }
+        if (h.magic.load(std::memory_order_acquire) != INSTRUMENT_TABLE_MAGIC || h.version != INSTRUMENT_TABLE_VERSION ||
+            h.capacity != kCapacity) {
+            munmap(data_, sizeof(InstrumentTableData));
+            throw std::runtime_error("合约表格式不匹配: " + path);
+        }
+    }
+
+    ~InstrumentTable() { munmap(data_, sizeof(InstrumentTableData)); }
+
+    InstrumentTable(const InstrumentTable&) = delete;
+    InstrumentTable& operator=(const InstrumentTable&) = delete;
+
+    // 返回合约 ID，未登记时返回 INSTRUMENT_NONE
+    uint32_t find(const char* symbol) const {
+        size_t len = strnlen(symbol, sizeof(InstrumentStatic::symbol) - 1);
+        for (uint32_t i = hash(symbol, len);; i = (i + 1) & (kCapacity * 2 - 1)) {
+            uint32_t id = data_->slots[i].load(std::memory_order_acquire);
+            if (id == INSTRUMENT_NONE) return INSTRUMENT_NONE;
+            const char* name = data_->entries[id].symbol;
+            if (memcmp(name, symbol, len) == 0 && name[len] == '\0') return id;
+        }
+    }
+
+    // 查找或登记合约；ref_price 用于选择小数位数，登记后不再改变。只读表中登记或表已满时抛出异常
+    uint32_t intern(const char* symbol, double ref_price) {
+        if (!writable_ && find(symbol) == INSTRUMENT_NONE) {
+            throw std::runtime_error(std::string("只读合约表中没有合约 ") + symbol);
+        }
+        uint32_t id = try_intern(symbol, ref_price);
+        if (id == INSTRUMENT_NONE) throw std::runtime_error("合约表已满 (" + std::to_string(kCapacity - 1) + ")");
+        return id;
+    }
+
+    // 同 intern，但不抛异常：只读表中没有该合约或表已满时返回 INSTRUMENT_NONE
+    uint32_t try_intern(const char* symbol, double ref_price) {
+        uint32_t id = find(symbol);
+        if (id == INSTRUMENT_NONE) return writable_ ? add(symbol, instrument_price_decimals(ref_price)) : id;
+        price_scale(id, ref_price); // 预登记的合约在此选定小数位数
+        return id;
+    }
+
+    // 预登记：只分配 ID，小数位数留到首笔行情由 price_scale(id, ref_price) 选定。
+    // 录制器在订阅前登记全部合约，行情回调线程只做无锁的 find，不持有进程间锁、不抛异常
+    uint32_t reserve(const char* symbol) {
+        uint32_t id = find(symbol);
+        return id != INSTRUMENT_NONE || !writable_ ? id : add(symbol, INSTRUMENT_DECIMALS_UNSET);
+    }
+
+    // 定点价格的比例 (10^小数位数)，尚未选定时为 0
+    double price_scale(uint32_t id) const {
+        return instrument_price_scale(data_->entries[id].price_decimals.load(std::memory_order_acquire));
+    }
+
+    // 同上，尚未选定时按 ref_price 选定 (无锁，多个线程/进程同时选定时以先完成 CAS 的为准)
+    double price_scale(uint32_t id, double ref_price) {
+        InstrumentStatic& entry = data_->entries[id];
+        uint32_t decimals = entry.price_decimals.load(std::memory_order_acquire);
+        if (decimals == INSTRUMENT_DECIMALS_UNSET && writable_) {
+            uint32_t chosen = instrument_price_decimals(ref_price);
+            if (entry.price_decimals.compare_exchange_strong(decimals, chosen, std::memory_order_acq_rel)) {
+                entry.price_scale = instrument_price_scale(chosen);
+                decimals = chosen;
+            }
+        }
+        return instrument_price_scale(decimals);
+    }
+
+    // 静态字段有变化时才进入顺序锁写
+    void update_statics(uint32_t id, const InstrumentStatics& s) {
+        InstrumentStatic& entry = data_->entries[id];
+        if (InstrumentStatics{entry.upper_limit, entry.lower_limit, entry.open_price, entry.pre_close_price} == s) {
+            return;
+        }
+        lock();
+        uint32_t seq = entry.seq.load(std::memory_order_relaxed);
+        entry.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        entry.upper_limit = s.upper_limit;
+        entry.lower_limit = s.lower_limit;
+        entry.open_price = s.open_price;
+        entry.pre_close_price = s.pre_close_price;
+        entry.seq.store(seq + 2, std::memory_order_release);
+        unlock();
+    }
+
+    InstrumentStatics statics(uint32_t id) const {
+        const InstrumentStatic& entry = data_->entries[id];
+        InstrumentStatics s;
+        for (;;) {
+            uint32_t seq = entry.seq.load(std::memory_order_acquire);
+            if (seq & 1) continue;
+            s.upper_limit = entry.upper_limit;
+            s.lower_limit = entry.lower_limit;
+            s.open_price = entry.open_price;
+            s.pre_close_price = entry.pre_close_price;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (entry.seq.load(std::memory_order_relaxed) == seq) return s;
+        }
+    }
+
+    const InstrumentStatic& at(uint32_t id) const { return data_->entries[id]; }
+    // 已分配 ID 的上界 (不含)，有效 ID 为 [1, end())
+    uint32_t end() const { return data_->header.count.load(std::memory_order_acquire); }
+    uint32_t size() const { return end() - 1; }
+    bool writable() const { return writable_; }
+    bool shared() const { return shared_; }
+
+private:
+    static uint32_t hash(const char* symbol, size_t len) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < len; ++i) {
+            h ^= static_cast<unsigned char>(symbol[i]);
+            h *= 16777619u;
+        }
+        return h & (kCapacity * 2 - 1);
+    }
+
+    // 持锁登记新合约，表已满时返回 INSTRUMENT_NONE
+    uint32_t add(const char* symbol, uint32_t decimals) {
+        lock();
+        uint32_t id = find(symbol); // 其它进程可能刚登记
+        if (id == INSTRUMENT_NONE) {
+            id = data_->header.count.load(std::memory_order_relaxed);
+            if (id >= kCapacity) {
+                unlock();
+                return INSTRUMENT_NONE;
+            }
+            InstrumentStatic& entry = data_->entries[id];
+            strncpy(entry.symbol, symbol, sizeof(entry.symbol) - 1);
+            entry.price_scale = instrument_price_scale(decimals);
+            entry.price_decimals.store(decimals, std::memory_order_relaxed);
+
+            size_t len = strnlen(entry.symbol, sizeof(entry.symbol));
+            uint32_t i = hash(entry.symbol, len);
+            while (data_->slots[i].load(std::memory_order_relaxed) != INSTRUMENT_NONE) i = (i + 1) & (kCapacity * 2 - 1);
+            data_->slots[i].store(id, std::memory_order_release);
+            data_->header.count.store(id + 1, std::memory_order_release);
+        }
+        unlock();
+        return id;
+    }
+
+    void init_header() {
+        InstrumentTableHeader& h = data_->header;
+        h.version = INSTRUMENT_TABLE_VERSION;
+        h.capacity = kCapacity;
+        h.count.store(1, std::memory_order_relaxed); // ID 0 保留
+        h.magic.store(INSTRUMENT_TABLE_MAGIC, std::memory_order_release);
+    }
+
+    // 登记锁：登记与静态字段更新都很少发生，直接自旋；持锁进程已退出时接管
+    void lock() {
+        InstrumentTableHeader& h = data_->header;
+        const int32_t self = static_cast<int32_t>(getpid());
+        for (uint32_t spins = 1;; ++spins) {
+            int32_t owner = 0;
+            if (h.lock.compare_exchange_weak(owner, self, std::memory_order_acquire)) return;
+            if ((spins & 1023) == 0 && owner != self && kill(owner, 0) != 0 && errno == ESRCH &&
+                h.lock.compare_exchange_strong(owner, self, std::memory_order_acquire)) {
+                recover();
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock() { data_->header.lock.store(0, std::memory_order_release); }
+
+    // 持锁进程在登记途中退出：槽位已发布而 count 未推进时补上，避免同一 ID 被再次分配
+    void recover() {
+        uint32_t count = data_->header.count.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < kCapacity * 2; ++i) {
+            uint32_t id = data_->slots[i].load(std::memory_order_relaxed);
+            if (id >= count) count = id + 1;
+        }
+        data_->header.count.store(count, std::memory_order_release);
+    }
+
+    InstrumentTableData* data_ = nullptr;
+    bool writable_ = true;
+    bool shared_ = false;
+};
+
+// 共享表存在时只读打开，否则返回空 (事件中的 instrument_id 保持 INSTRUMENT_NONE)
+inline std::unique_ptr<InstrumentTable> open_instrument_table(const std::string& path) {
+    struct stat st;
+    if (path.empty() || stat(path.c_str(), &st) != 0) return nullptr;
+    return std::make_unique<InstrumentTable>(path, false);
+}
+
+// ---------------------------------------------------------
+// 按合约保存状态时的下标。共享表删除重建后会重新编号，旧日志中的 ID 可能已指向别的合约，
+// 因此事件携带的 ID 只有在共享表中登记的名称与 symbol 一致时才直接使用；否则按名称在共享表中查找，
+// 共享表中没有 (或没有共享表) 时使用本地编号 (从 kCapacity 起)。
+// 每个合约第一次出现时选定下标并缓存 (以本地表登记合约名)，之后总是返回同一下标：
+// 先于共享表登记而使用了本地编号的合约，之后即使共享表登记了它也不会换下标。下标范围 [1, kSlots)。
+// 本地表登记满时返回 kOverflow 并计数；共享表打不开时告警并只用本地表。不抛异常，可在总线回调 (含分片线程) 中调用
+// ---------------------------------------------------------
+class InstrumentIndex {
+public:
+    static constexpr uint32_t kSlots = 2 * INSTRUMENT_CAPACITY;
+    static constexpr uint32_t kOverflow = 0;
+
+    // 默认只读打开 INSTRUMENT_TABLE_DEFAULT_PATH，不存在时只用本地表
+    InstrumentIndex() { open_registry(INSTRUMENT_TABLE_DEFAULT_PATH); }
+
+    // 改用指定路径的共享表 (模块的 instrument_registry 配置)，须在处理事件之前调用；路径为空表示不用共享表
+    void open_registry(const std::string& path) {
+        try {
+            registry_ = open_instrument_table(path);
+        } catch (const std::exception& e) {
+            // 例如旧版本留下的表大小或格式不匹配：不影响模块加载，按合约名在本地编号
+            std::cerr << "[InstrumentIndex] 共享合约表不可用，只使用本地表: " << e.what() << std::endl;
+            registry_.reset();
+        }
+        for (uint32_t i = 0; i < INSTRUMENT_CAPACITY; ++i) by_registry_[i].store(kOverflow, std::memory_order_relaxed);
+    }
+
+    uint32_t operator()(uint32_t id, const char* symbol) {
+        const bool id_ok = registry_ && id != INSTRUMENT_NONE && id < registry_->end() &&
+                           strncmp(registry_->at(id).symbol, symbol, sizeof(InstrumentStatic::symbol) - 1) == 0;
+        if (id_ok) {
+            uint32_t cached = by_registry_[id].load(std::memory_order_acquire);
+            if (cached != kOverflow) return cached;
+        }
+
+        uint32_t local = local_.try_intern(symbol, 0);
+        if (local == INSTRUMENT_NONE) {
+            if (overflow_.fetch_add(1, std::memory_order_relaxed) == 0) {
+                std::cerr << "[InstrumentIndex] 本地合约表已满，忽略合约 " << symbol << " 等的事件" << std::endl;
+            }
+            return kOverflow;
+        }
+        uint32_t slot = slots_[local].load(std::memory_order_acquire);
+        if (slot == kOverflow) {
+            // 第一次出现：优先用共享表的 ID，多个线程同时选定时以先完成 CAS 的为准
+            uint32_t chosen = INSTRUMENT_CAPACITY + local;
+            if (registry_) {
+                uint32_t found = id_ok ? id : registry_->find(symbol);
+                if (found != INSTRUMENT_NONE) chosen = found;
+            }
+            if (slots_[local].compare_exchange_strong(slot, chosen, std::memory_order_acq_rel)) slot = chosen;
+        }
+        if (id_ok) by_registry_[id].store(slot, std::memory_order_release);
+        return slot;
+    }
+
+    // 因本地表已满而返回 kOverflow 的次数
+    uint64_t overflow() const { return overflow_.load(std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<InstrumentTable> registry_;
+    InstrumentTable local_; // 见过的全部合约名 -> 本地 ID
+    std::unique_ptr<std::atomic<uint32_t>[]> slots_{new std::atomic<uint32_t>[INSTRUMENT_CAPACITY]()};       // 本地 ID -> 下标
+    std::unique_ptr<std::atomic<uint32_t>[]> by_registry_{new std::atomic<uint32_t>[INSTRUMENT_CAPACITY]()}; // 共享表 ID -> 下标
+    std::atomic<uint64_t> overflow_{0};
+};
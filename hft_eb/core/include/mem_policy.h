@@ -0,0 +1,94 @@
+#pragma once
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+// 旧内核头文件中可能没有 (Linux 5.14+)
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+// ---------------------------------------------------------
+// 内存映射策略：消除热路径上首次访问页面的缺页中断
+// - populate: 映射后立即预缺页 (MADV_POPULATE_*，不修改内容，可与写者并发；旧内核退化为 MAP_POPULATE)
+// - lock: mlock 常驻内存，防止被换出 (受 RLIMIT_MEMLOCK 限制，失败时告警并继续)
+// - huge_pages: 匿名内存优先 MAP_HUGETLB (需预留大页)，否则 MADV_HUGEPAGE；
+//   文件映射只能 MADV_HUGEPAGE，仅在 tmpfs (huge=advise) 等支持大页的文件系统上生效
+// ---------------------------------------------------------
+struct MemoryPolicy {
+    bool populate = false;
+    bool lock = false;
+    bool huge_pages = false;
+};
+
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// 对已映射区域应用策略 (先大页建议，再预缺页，最后锁定)。
+// 返回 false 表示内核不支持 MADV_POPULATE_*，由调用方退化处理 (例如以 MAP_POPULATE 重新映射)
+inline bool apply_memory_policy(void* addr, size_t len, const MemoryPolicy& policy, bool writable) {
+    bool populated = true;
+    if (policy.huge_pages && madvise(addr, len, MADV_HUGEPAGE) != 0) {
+        std::cerr << "[Mem] MADV_HUGEPAGE 失败: " << strerror(errno) << std::endl;
+    }
+    if (policy.populate && madvise(addr, len, writable ? MADV_POPULATE_WRITE : MADV_POPULATE_READ) != 0) {
+        populated = false;
+    }
+    if (policy.lock && mlock(addr, len) != 0) {
+        std::cerr << "[Mem] mlock " << len << " 字节失败: " << strerror(errno)
+                  << " (检查 ulimit -l)" << std::endl;
+    }
+    return populated;
+}
+
+// 分配匿名内存 (用于 RingBuffer 等常驻缓冲)，*mapped_len 返回实际映射长度
+inline void* map_anonymous(size_t size, const MemoryPolicy& policy, size_t* mapped_len) {
+    void* ptr = MAP_FAILED;
+    size_t len = size;
+    if (policy.huge_pages) {
+        len = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+    if (ptr == MAP_FAILED) {
+        ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) throw std::bad_alloc();
+        if (!apply_memory_policy(ptr, len, policy, true)) {
+            // 新分配的匿名内存全为 0，逐页写 0 预缺页是安全的
+            for (size_t off = 0; off < len; off += 4096) static_cast<volatile char*>(ptr)[off] = 0;
+        }
+    } else {
+        // MAP_HUGETLB 映射本身就是大页，无需 MADV_HUGEPAGE
+        MemoryPolicy rest = policy;
+        rest.huge_pages = false;
+        apply_memory_policy(ptr, len, rest, true);
+    }
+    *mapped_len = len;
+    return ptr;
+}
+
+// 缺页计数 (getrusage)，用于验证预缺页、大页的效果
+struct PageFaults {
+    uint64_t minor = 0;
+    uint64_t major = 0;
+
+    PageFaults operator-(const PageFaults& o) const { return {minor - o.minor, major - o.major}; }
+};
+
+inline PageFaults thread_page_faults() {
+    rusage ru{};
+    getrusage(RUSAGE_THREAD, &ru);
+    return {static_cast<uint64_t>(ru.ru_minflt), static_cast<uint64_t>(ru.ru_majflt)};
+}
+
+inline PageFaults process_page_faults() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return {static_cast<uint64_t>(ru.ru_minflt), static_cast<uint64_t>(ru.ru_majflt)};
+}
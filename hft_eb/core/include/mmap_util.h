@@ -2,131 +2,1000 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <cerrno>
 #include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <immintrin.h> // 用于 _mm_pause
 #include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <vector>
 #include <stdexcept>
 #include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "mem_policy.h"
+#include "crc32c.h"
+#include "record_layout.h"
 
 // 元数据头 (4KB 对齐)
 struct MetaHeader {
-    std::atomic<uint64_t> write_cursor; // 已写入条数
-    uint64_t capacity;                  // 总容量 (条数)
-    char padding[4096 - 16];            // 补齐，避免伪共享
+    std::atomic<uint64_t> write_cursor; // 已写入条数 (跨所有分段的逻辑游标)
+    uint64_t capacity;                  // 单个分段的容量 (条数)
+    std::atomic<uint64_t> segments;     // 已创建的分段文件数 (含预创建的)；旧格式为 0，即只有一个 .dat
+    std::atomic<uint32_t> futex_word;   // 唤醒序号，写者每次唤醒加 1，睡眠读者在其上 futex 等待
+    std::atomic<uint32_t> waiters;      // 准备睡眠的读者数，写者唤醒后清零 (崩溃读者留下的计数也随之自愈)
+    char pad0[64 - 32];
+    // 多生产者模式 (MmapMultiWriter)：预留游标单独占一个缓存行，与读者轮询的 write_cursor 分开
+    std::atomic<uint64_t> reserve_cursor; // 已预留的槽位数，write_cursor 为其中已连续提交的前缀
+    std::atomic<uint32_t> mode;           // JOURNAL_SINGLE_PRODUCER / JOURNAL_MULTI_PRODUCER
+    uint32_t flags;                       // JOURNAL_FLAG_*，创建时确定
+    std::atomic<uint64_t> synced_cursor;  // 持久化模式：此前的记录已落盘 (fdatasync 后更新)
+    // 记录格式 (自描述)：创建时由写者登记，读写两端与当前二进制的 T 比对；旧文件全为 0
+    std::atomic<uint32_t> magic;          // JOURNAL_MAGIC，最后写入，非 0 表示以下字段有效
+    uint32_t version;                     // 日志格式版本
+    uint32_t record_size;                 // sizeof(T)
+    uint32_t reserved0;
+    uint64_t layout_hash;                 // RecordLayout<T>::hash
+    char record_name[32];                 // RecordLayout<T>::name，便于工具识别
+    char padding[4096 - 144];             // 补齐，避免伪共享
 };
+static_assert(sizeof(MetaHeader) == 4096, "MetaHeader must stay 4KB");
+
+static constexpr uint32_t JOURNAL_SINGLE_PRODUCER = 0;
+static constexpr uint32_t JOURNAL_MULTI_PRODUCER = 1;
+static constexpr uint32_t JOURNAL_CONVERTING = 2; // 首个多生产者正在接管单生产者日志
+
+static constexpr uint32_t JOURNAL_FLAG_FRAMED = 1;   // 每条记录带序号与 CRC32C (.frm 旁路文件)
+static constexpr uint32_t JOURNAL_FLAG_CIRCULAR = 2; // 定长循环日志 (circular_journal.h)，只有一个 .dat，游标对容量取模
+
+static constexpr uint32_t JOURNAL_MAGIC = 0x4C4E4A48; // "HJNL"
+static constexpr uint32_t JOURNAL_VERSION = 1;
+
+// 登记记录格式；多个生产者并发登记同一类型时写入的内容相同
+template <typename T>
+inline void journal_stamp_layout(MetaHeader* meta) {
+    meta->version = JOURNAL_VERSION;
+    meta->record_size = sizeof(T);
+    meta->layout_hash = RecordLayout<T>::hash;
+    strncpy(meta->record_name, RecordLayout<T>::name, sizeof(meta->record_name) - 1);
+    meta->magic.store(JOURNAL_MAGIC, std::memory_order_release);
+}
+
+// 登记记录格式之前写入的日志 (magic 为 0) 都由当时的 TickRecord 写入，即 tick_record_legacy.h 中的 TickRecordV1
+static constexpr const char* JOURNAL_UNSTAMPED_LAYOUT = "TickRecordV1";
+
+// 与 T 的布局比对，返回不匹配原因；匹配返回空串。未登记的旧文件只与 TickRecordV1 匹配
+template <typename T>
+inline std::string journal_layout_mismatch(const MetaHeader* meta) {
+    uint32_t magic = meta->magic.load(std::memory_order_acquire);
+    if (magic == 0) {
+        if (strcmp(RecordLayout<T>::name, JOURNAL_UNSTAMPED_LAYOUT) == 0) return "";
+        return std::string("未登记记录布局的旧日志按 ") + JOURNAL_UNSTAMPED_LAYOUT + " 处理，与当前 " +
+               RecordLayout<T>::name + " 不一致";
+    }
+    if (magic != JOURNAL_MAGIC) return "魔数错误";
+    if (meta->version > JOURNAL_VERSION) {
+        return "格式版本 " + std::to_string(meta->version) + " 高于支持的 " + std::to_string(JOURNAL_VERSION);
+    }
+    if (meta->record_size != sizeof(T)) {
+        return "记录大小 " + std::to_string(meta->record_size) + "，当前 " + std::to_string(sizeof(T));
+    }
+    if (meta->layout_hash != RecordLayout<T>::hash) {
+        return std::string("记录布局 ") + meta->record_name + " 与当前 " + RecordLayout<T>::name + " 不一致";
+    }
+    return "";
+}
+
+inline std::runtime_error journal_layout_error(const std::string& reason, const std::string& base_path) {
+    return std::runtime_error("日志记录格式不匹配 (" + reason + "): " + base_path + "，请先用 hft_convert 迁移");
+}
+
+// 分段文件名：第 0 段为 <base><ext> (兼容单文件格式)，之后为 <base>.<n><ext>
+inline std::string mmap_segment_file(const std::string& base_path, uint64_t index, const char* ext) {
+    if (index == 0) return base_path + ext;
+    return base_path + "." + std::to_string(index) + ext;
+}
+
+// 数据分段：<base>.dat, <base>.1.dat ...
+inline std::string mmap_segment_path(const std::string& base_path, uint64_t index) {
+    return mmap_segment_file(base_path, index, ".dat");
+}
+
+// 多生产者模式下每个分段对应的提交序号文件：<base>.seq, <base>.<n>.seq，每个槽位一个 uint64_t
+inline std::string mmap_commit_path(const std::string& base_path, uint64_t index) {
+    return mmap_segment_file(base_path, index, ".seq");
+}
+
+// 记录帧 (framed 模式)：每个分段一个 <base>[.<n>].frm 旁路文件，与数据槽位一一对应，数据文件格式不变
+struct RecordFrame {
+    uint64_t seq;      // 槽位序号 + 1，0 表示从未写入
+    uint32_t crc;      // 记录内容的 CRC32C
+    uint32_t reserved;
+};
+
+inline std::string mmap_frame_path(const std::string& base_path, uint64_t index) {
+    return mmap_segment_file(base_path, index, ".frm");
+}
+
+// 写入器的持久化选项
+// - framed: 新建日志时启用记录帧，崩溃/掉电后可以逐条校验，截断到最后一条有效记录
+// - sync_interval_ms: 大于 0 时由后台线程按该周期批量 fdatasync 数据分段，再更新并 msync synced_cursor；
+//   写线程不增加任何系统调用。重启时只需校验 [synced_cursor, write_cursor) 这一段
+struct JournalDurability {
+    bool framed = false;
+    uint32_t sync_interval_ms = 0;
+};
+
+// 读者等待新数据的方式
+enum class WaitPolicy {
+    Spin,   // 纯自旋 (_mm_pause)，延迟最低，独占一个核
+    Hybrid, // 先自旋 spin_count 次，仍无数据再 futex 睡眠
+    Block,  // 直接 futex 睡眠，适合研究、监控等被动读者
+};
+
+// MetaHeader 所在映射为 MAP_SHARED 文件映射，使用共享 futex 即可跨进程唤醒
+inline void futex_wait(std::atomic<uint32_t>* addr, uint32_t expected, const timespec* timeout) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+inline void futex_wake_all(std::atomic<uint32_t>* addr) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// 唤醒所有在 futex_word 上睡眠的读者
+inline void mmap_wake_readers(MetaHeader* meta) {
+    meta->waiters.store(0, std::memory_order_relaxed);
+    meta->futex_word.fetch_add(1, std::memory_order_release);
+    futex_wake_all(&meta->futex_word);
+}
+
+// 映射一个文件，create 时按 size 截断 (稀疏文件，未写入的页不占磁盘)。
+// policy 在返回前生效，只能用于尚未被其他线程访问的映射；内核不支持 MADV_POPULATE_* 时以 MAP_POPULATE 重新映射
+inline void* mmap_file(const std::string& path, size_t size, bool writable, bool create,
+                       const MemoryPolicy& policy = MemoryPolicy{}) {
+    int flags = writable ? O_RDWR : O_RDONLY;
+    if (create) flags |= O_CREAT;
+    int fd = open(path.c_str(), flags, 0666);
+    if (fd < 0) throw std::runtime_error("无法打开文件: " + path);
+
+    if (create && ftruncate(fd, size) != 0) {
+        close(fd);
+        throw std::runtime_error("ftruncate 失败: " + path);
+    }
+
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* ptr = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    if (ptr != MAP_FAILED && !apply_memory_policy(ptr, size, policy, writable) &&
+        mmap(ptr, size, prot, MAP_SHARED | MAP_FIXED | MAP_POPULATE, fd, 0) == MAP_FAILED) {
+        // MAP_FIXED 失败后原映射的状态不确定，整段解除
+        munmap(ptr, size);
+        close(fd);
+        throw std::runtime_error("mmap (MAP_POPULATE) 失败: " + path);
+    }
+    close(fd);
+    if (ptr == MAP_FAILED) throw std::runtime_error("mmap 失败: " + path);
+    return ptr;
+}
+
+// 校验 [begin, end) 内的记录帧，返回第一条无效记录的序号 (全部有效时返回 end)。
+// 分段文件缺失视为该段起全部无效。只读映射，可以多线程对不同区间并发调用
+template <typename T>
+uint64_t journal_first_invalid(const std::string& base_path, uint64_t capacity, uint64_t begin, uint64_t end) {
+    uint64_t n = begin;
+    while (n < end) {
+        uint64_t index = n / capacity;
+        uint64_t seg_base = index * capacity;
+        uint64_t seg_end = std::min(end, seg_base + capacity);
+
+        const T* data = nullptr;
+        const RecordFrame* frames = nullptr;
+        try {
+            data = static_cast<const T*>(mmap_file(mmap_segment_path(base_path, index), capacity * sizeof(T), false, false));
+            frames = static_cast<const RecordFrame*>(
+                mmap_file(mmap_frame_path(base_path, index), capacity * sizeof(RecordFrame), false, false));
+        } catch (const std::exception&) {
+            if (data) munmap(const_cast<T*>(data), capacity * sizeof(T));
+            return n;
+        }
+
+        for (; n < seg_end; ++n) {
+            const RecordFrame& f = frames[n - seg_base];
+            if (f.seq != n + 1 || f.crc != crc32c(&data[n - seg_base], sizeof(T))) break;
+        }
+
+        munmap(const_cast<T*>(data), capacity * sizeof(T));
+        munmap(const_cast<RecordFrame*>(frames), capacity * sizeof(RecordFrame));
+        if (n < seg_end) return n;
+    }
+    return end;
+}
+
+// 多生产者日志中已预留但未提交的槽位 (生产者在预留后、提交前崩溃，或切换分段失败)：
+// 统计 [write_cursor, reserve_cursor) 内的空洞数；apply 时把其后已提交的记录前移填补空洞，
+// 清掉腾出槽位的提交序号，再把两个游标都设为压实后的末尾。apply 前必须先停止所有写入进程
+template <typename T>
+uint64_t journal_compact_reserved(const std::string& base_path, MetaHeader* meta, bool apply) {
+    const uint64_t capacity = meta->capacity;
+    const uint64_t begin = meta->write_cursor.load();
+    const uint64_t end = meta->reserve_cursor.load();
+    if (meta->mode.load() != JOURNAL_MULTI_PRODUCER || end <= begin) return 0;
+
+    // 按需映射分段；扫描时缺失的分段视为未提交，压实时按需创建
+    struct Mapped {
+        uint64_t index = UINT64_MAX;
+        T* data = nullptr;
+        std::atomic<uint64_t>* seq = nullptr;
+    };
+    std::vector<Mapped> maps;
+    auto unmap_all = [&] {
+        for (auto& m : maps) {
+            if (m.data) munmap(m.data, capacity * sizeof(T));
+            if (m.seq) munmap(m.seq, capacity * sizeof(uint64_t));
+        }
+        maps.clear();
+    };
+    auto segment = [&](uint64_t n, bool create) -> Mapped {
+        uint64_t index = n / capacity;
+        for (auto& m : maps) {
+            if (m.index == index) return m;
+        }
+        Mapped m;
+        m.index = index;
+        try {
+            m.seq = static_cast<std::atomic<uint64_t>*>(
+                mmap_file(mmap_commit_path(base_path, index), capacity * sizeof(uint64_t), apply, create));
+            m.data = static_cast<T*>(mmap_file(mmap_segment_path(base_path, index), capacity * sizeof(T), apply, create));
+        } catch (const std::exception&) {
+            if (m.seq) munmap(m.seq, capacity * sizeof(uint64_t));
+            if (create) {
+                unmap_all();
+                throw;
+            }
+            return Mapped{};
+        }
+        maps.push_back(m);
+        return m;
+    };
+    auto committed = [&](uint64_t n) {
+        Mapped m = segment(n, false);
+        return m.seq && m.seq[n - m.index * capacity].load() == n + 1;
+    };
+
+    uint64_t holes = 0;
+    uint64_t out = begin;
+    try {
+        for (uint64_t n = begin; n < end; ++n) {
+            if (!committed(n)) {
+                holes++;
+                continue;
+            }
+            if (apply && out != n) {
+                Mapped src = segment(n, false);
+                Mapped dst = segment(out, true);
+                dst.data[out - dst.index * capacity] = src.data[n - src.index * capacity];
+                dst.seq[out - dst.index * capacity].store(out + 1);
+            }
+            out++;
+        }
+        if (apply) {
+            // 腾出的槽位必须清零，否则新预留的生产者会被残留的提交序号误判为已提交
+            for (uint64_t n = out; n < end; ++n) {
+                Mapped m = segment(n, false);
+                if (m.seq) m.seq[n - m.index * capacity].store(0);
+            }
+            uint64_t count = meta->segments.load();
+            if (out > 0 && count < (out - 1) / capacity + 1) meta->segments.store((out - 1) / capacity + 1);
+            meta->reserve_cursor.store(out);
+            meta->write_cursor.store(out);
+            for (auto& m : maps) {
+                msync(m.data, capacity * sizeof(T), MS_SYNC);
+                msync(m.seq, capacity * sizeof(uint64_t), MS_SYNC);
+            }
+        }
+    } catch (...) {
+        unmap_all();
+        throw;
+    }
+    unmap_all();
+    return holes;
+}
+
+// 打开/创建元数据文件并映射为可写
+inline MetaHeader* mmap_meta_for_write(const std::string& base_path) {
+    std::string meta_path = base_path + ".meta";
+
+    int fd_meta = open(meta_path.c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd_meta < 0) throw std::runtime_error("无法打开元数据文件: " + meta_path);
+
+    if (ftruncate(fd_meta, sizeof(MetaHeader)) != 0) {
+        close(fd_meta);
+        throw std::runtime_error("ftruncate 元数据文件失败");
+    }
+
+    void* ptr = mmap(nullptr, sizeof(MetaHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd_meta, 0);
+    close(fd_meta);
+    if (ptr == MAP_FAILED) throw std::runtime_error("mmap 元数据文件失败");
+    return static_cast<MetaHeader*>(ptr);
+}
+
+// 读者映射元数据：Spin 模式只读；其余模式需要读写 (登记等待者)，无写权限时退化为 Spin 并改写 policy
+inline MetaHeader* mmap_meta_for_read(const std::string& base_path, WaitPolicy& policy) {
+    std::string meta_path = base_path + ".meta";
+
+    int fd_meta = -1;
+    if (policy != WaitPolicy::Spin) {
+        fd_meta = open(meta_path.c_str(), O_RDWR);
+        if (fd_meta < 0 && errno == EACCES) {
+            std::cerr << "[Mmap] 元数据文件不可写，退化为自旋等待: " << meta_path << std::endl;
+            policy = WaitPolicy::Spin;
+        }
+    }
+    if (policy == WaitPolicy::Spin) fd_meta = open(meta_path.c_str(), O_RDONLY);
+    if (fd_meta < 0) throw std::runtime_error("无法打开元数据文件: " + meta_path);
+
+    int prot = policy == WaitPolicy::Spin ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* ptr = mmap(nullptr, sizeof(MetaHeader), prot, MAP_SHARED, fd_meta, 0);
+    close(fd_meta);
+    if (ptr == MAP_FAILED) throw std::runtime_error("mmap 元数据文件失败");
+    return static_cast<MetaHeader*>(ptr);
+}
+
+// 按 policy 等待 ready() 为真，最多等待 timeout；返回 true 表示已有数据可读。
+// 阻塞等待的读者先取唤醒序号、登记等待者，再复查：写者要么看到等待者并唤醒，要么读者看到新游标
+template <typename Ready>
+bool mmap_wait(MetaHeader* meta, WaitPolicy policy, uint32_t spin_count, std::chrono::microseconds timeout,
+               Ready ready) {
+    if (ready()) return true;
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    if (policy != WaitPolicy::Block) {
+        for (uint32_t i = 0; i < spin_count; ++i) {
+            _mm_pause();
+            if (ready()) return true;
+        }
+    }
+
+    if (policy == WaitPolicy::Spin) {
+        // 每自旋一轮检查一次时钟，避免频繁读时钟
+        while (std::chrono::steady_clock::now() < deadline) {
+            for (int i = 0; i < 1024; ++i) {
+                _mm_pause();
+                if (ready()) return true;
+            }
+        }
+        return ready();
+    }
+
+    for (;;) {
+        uint32_t seq = meta->futex_word.load(std::memory_order_acquire);
+        meta->waiters.fetch_add(1, std::memory_order_seq_cst);
+        if (ready()) return true;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) return false;
+        auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+        timespec ts{static_cast<time_t>(left / 1000000000), static_cast<long>(left % 1000000000)};
+        futex_wait(&meta->futex_word, seq, &ts);
+        if (ready()) return true;
+    }
+}
 
 // ---------------------------------------------------------
 // Mmap 写入器 (单生产者)
+// 数据按固定大小分段存放，写满一段后切换到下一段；下一段总是由后台线程提前创建并映射好，
+// 切换时只需交换指针。逻辑游标 write_cursor 跨分段连续，读者无需关心分段。
+// policy 作用于数据分段：后台线程先对当前分段游标之后的部分预缺页，再创建、预缺页、锁定下一段，
+// 写线程不会在首次写入某页时触发缺页中断。
+// durability 见 JournalDurability：记录帧写在旁路文件中，读者无需改动；重启时校验未确认落盘的尾部。
 // ---------------------------------------------------------
 template <typename T>
 class MmapWriter {
 public:
-    // capacity: 能够存储的记录总数
-    MmapWriter(const std::string& base_path, uint64_t capacity) {
-        std::string dat_path = base_path + ".dat";
-        std::string meta_path = base_path + ".meta";
-
-        // 1. 打开/创建数据文件
-        int fd_dat = open(dat_path.c_str(), O_RDWR | O_CREAT, 0666);
-        if (fd_dat < 0) throw std::runtime_error("无法打开数据文件: " + dat_path);
-        
-        // 预分配空间
-        uint64_t dat_size = capacity * sizeof(T);
-        if (ftruncate(fd_dat, dat_size) != 0) throw std::runtime_error("ftruncate 数据文件失败");
-
-        data_ptr_ = (T*)mmap(nullptr, dat_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_dat, 0);
-        if (data_ptr_ == MAP_FAILED) throw std::runtime_error("mmap 数据文件失败");
-        close(fd_dat);
-
-        // 2. 打开/创建元数据文件
-        int fd_meta = open(meta_path.c_str(), O_RDWR | O_CREAT, 0666);
-        if (fd_meta < 0) throw std::runtime_error("无法打开元数据文件: " + meta_path);
-        
-        if (ftruncate(fd_meta, sizeof(MetaHeader)) != 0) throw std::runtime_error("ftruncate 元数据文件失败");
-
-        meta_ptr_ = (MetaHeader*)mmap(nullptr, sizeof(MetaHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd_meta, 0);
-        if (meta_ptr_ == MAP_FAILED) throw std::runtime_error("mmap 元数据文件失败");
-        close(fd_meta);
+    // capacity: 单个分段能够存储的记录数 (已有文件时沿用文件中的分段大小与 framed 设置)
+    MmapWriter(const std::string& base_path, uint64_t capacity, const MemoryPolicy& policy = MemoryPolicy{},
+               const JournalDurability& durability = JournalDurability{})
+        : base_path_(base_path), policy_(policy) {
+        // 1. 打开/创建元数据文件
+        meta_ptr_ = mmap_meta_for_write(base_path);
+        if (meta_ptr_->mode.load() != JOURNAL_SINGLE_PRODUCER) {
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            throw std::runtime_error("多生产者日志只能用 MmapMultiWriter 写入: " + base_path);
+        }
+        if (meta_ptr_->flags & JOURNAL_FLAG_CIRCULAR) {
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            throw std::runtime_error("循环日志只能用 CircularWriter 写入: " + base_path);
+        }
 
-        // 初始化元数据
+        // 初始化元数据；旧的单文件格式视为只有第 0 段
         if (meta_ptr_->capacity == 0) {
             meta_ptr_->capacity = capacity;
             meta_ptr_->write_cursor = 0;
+            meta_ptr_->segments = 0;
+            meta_ptr_->flags = durability.framed ? JOURNAL_FLAG_FRAMED : 0;
+            meta_ptr_->synced_cursor = 0;
+            journal_stamp_layout<T>(meta_ptr_);
+        } else {
+            if (meta_ptr_->segments.load() == 0) meta_ptr_->segments = 1;
+            std::string reason = journal_layout_mismatch<T>(meta_ptr_);
+            if (!reason.empty()) {
+                munmap(meta_ptr_, sizeof(MetaHeader));
+                throw journal_layout_error(reason, base_path);
+            }
+            // 只有按 TickRecordV1 续写未登记的旧日志时才会走到这里，登记的即是其实际布局
+            if (meta_ptr_->magic.load() == 0) journal_stamp_layout<T>(meta_ptr_);
+        }
+        capacity_ = meta_ptr_->capacity;
+        framed_ = (meta_ptr_->flags & JOURNAL_FLAG_FRAMED) != 0;
+
+        // 2. 续写带帧的日志时，先校验未确认落盘的尾部，截断到最后一条有效记录
+        uint64_t cursor = meta_ptr_->write_cursor.load();
+        if (framed_ && cursor > 0) {
+            uint64_t synced = std::min(meta_ptr_->synced_cursor.load(), cursor);
+            uint64_t valid = journal_first_invalid<T>(base_path_, capacity_, synced, cursor);
+            if (valid < cursor) {
+                std::cerr << "[Mmap] " << base_path_ << " 尾部 " << (cursor - valid)
+                          << " 条记录校验失败，截断到 " << valid << std::endl;
+                meta_ptr_->write_cursor.store(valid);
+                cursor = valid;
+            }
+            if (meta_ptr_->synced_cursor.load() > cursor) meta_ptr_->synced_cursor.store(cursor);
+        }
+
+        // 3. 映射当前分段 (续写时从游标所在分段开始)，并预创建下一段；当前分段的预缺页同样交给后台线程
+        uint64_t index = cursor / capacity_;
+        cur_ = create_segment(index, MemoryPolicy{});
+        segment_index_ = index;
+        segment_base_ = index * capacity_;
+        prepare_next(cursor - segment_base_);
+
+        if (durability.sync_interval_ms > 0) {
+            syncer_ = std::thread(&MmapWriter::sync_loop, this, durability.sync_interval_ms);
         }
     }
 
+    ~MmapWriter() {
+        if (syncer_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(sync_mutex_);
+                stopping_ = true;
+            }
+            sync_cv_.notify_one();
+            syncer_.join();
+        } else if (framed_) {
+            // 正常关闭时落盘一次，下次打开无需校验整个日志
+            sync_once();
+        }
+        if (preparer_.joinable()) preparer_.join();
+        release(next_);
+        release(cur_);
+        if (meta_ptr_) munmap(meta_ptr_, sizeof(MetaHeader));
+    }
+
+    MmapWriter(const MmapWriter&) = delete;
+    MmapWriter& operator=(const MmapWriter&) = delete;
+
     bool write(const T& record) {
         uint64_t cursor = meta_ptr_->write_cursor.load(std::memory_order_relaxed);
-        if (cursor >= meta_ptr_->capacity) return false;
+        uint64_t offset = cursor - segment_base_;
+        if (offset >= capacity_) {
+            // 当前分段写满：切换到预创建的下一段 (只在分段边界发生)
+            if (!advance()) return false;
+            offset = 0;
+        }
+
+        // 1. 拷贝数据 (带帧时同时写入序号与校验和)
+        cur_.data[offset] = record;
+        if (framed_) {
+            cur_.frames[offset] = RecordFrame{cursor + 1, crc32c(&record, sizeof(T)), 0};
+        }
 
-        // 1. 拷贝数据
-        data_ptr_[cursor] = record;
-        
         // 2. 内存屏障，确保数据先于游标可见
         std::atomic_thread_fence(std::memory_order_release);
 
-        // 3. 更新游标
-        meta_ptr_->write_cursor.fetch_add(1, std::memory_order_relaxed);
+        // 3. 更新游标 (x86 上 lock xadd 本身即全屏障，seq_cst 不额外收费)
+        meta_ptr_->write_cursor.fetch_add(1, std::memory_order_seq_cst);
+
+        // 4. 有读者准备睡眠时才唤醒，没有等待者时热路径只多一次读
+        if (meta_ptr_->waiters.load(std::memory_order_seq_cst) != 0) mmap_wake_readers(meta_ptr_);
         return true;
     }
 
 private:
-    T* data_ptr_ = nullptr;
+    struct Segment {
+        T* data = nullptr;
+        RecordFrame* frames = nullptr; // 仅 framed 模式
+    };
+
+    size_t segment_bytes() const { return capacity_ * sizeof(T); }
+    size_t frame_bytes() const { return capacity_ * sizeof(RecordFrame); }
+
+    Segment create_segment(uint64_t index, const MemoryPolicy& policy) {
+        Segment seg;
+        seg.data = static_cast<T*>(
+            mmap_file(mmap_segment_path(base_path_, index), segment_bytes(), true, true, policy));
+        if (framed_) {
+            try {
+                seg.frames = static_cast<RecordFrame*>(
+                    mmap_file(mmap_frame_path(base_path_, index), frame_bytes(), true, true, policy));
+            } catch (...) {
+                munmap(seg.data, segment_bytes());
+                throw;
+            }
+        }
+        // 文件就绪后再登记分段数
+        uint64_t count = meta_ptr_->segments.load(std::memory_order_relaxed);
+        while (count < index + 1 &&
+               !meta_ptr_->segments.compare_exchange_weak(count, index + 1, std::memory_order_release)) {
+        }
+        return seg;
+    }
+
+    void release(Segment& seg) {
+        if (seg.data) munmap(seg.data, segment_bytes());
+        if (seg.frames) munmap(seg.frames, frame_bytes());
+        seg = Segment{};
+    }
+
+    // 后台创建并映射下一段，避免写线程在分段边界上做文件系统调用。
+    // current_from: 当前分段从该下标起需要预缺页 (仅构造时；MADV_POPULATE_WRITE 不改内容，可与写线程并发)
+    void prepare_next(uint64_t current_from = UINT64_MAX) {
+        uint64_t index = segment_index_ + 1;
+        Segment current = cur_;
+        preparer_ = std::thread([this, index, current, current_from] {
+            if (current_from < capacity_) {
+                // 从游标所在页开始 (madvise 要求页对齐)
+                size_t begin = (current_from * sizeof(T)) & ~size_t(4095);
+                apply_memory_policy(reinterpret_cast<char*>(current.data) + begin, segment_bytes() - begin, policy_, true);
+                if (current.frames) apply_memory_policy(current.frames, frame_bytes(), policy_, true);
+            }
+            try {
+                next_ = create_segment(index, policy_);
+            } catch (const std::exception& e) {
+                std::cerr << "[Mmap] 预创建分段失败: " << e.what() << std::endl;
+                next_ = Segment{};
+            }
+        });
+    }
+
+    bool advance() {
+        if (preparer_.joinable()) preparer_.join();
+        if (!next_.data) {
+            // 预创建失败 (例如磁盘满)，同步重试一次
+            try {
+                next_ = create_segment(segment_index_ + 1, policy_);
+            } catch (const std::exception& e) {
+                std::cerr << "[Mmap] 创建分段失败: " << e.what() << std::endl;
+                return false;
+            }
+        }
+
+        release(cur_);
+        cur_ = next_;
+        next_ = Segment{};
+        segment_index_++;
+        segment_base_ += capacity_;
+        prepare_next();
+        return true;
+    }
+
+    // 持久化线程：周期性地把新写入的分段 fdatasync 落盘，再推进并 msync synced_cursor
+    void sync_loop(uint32_t interval_ms) {
+        std::unique_lock<std::mutex> lock(sync_mutex_);
+        while (!stopping_) {
+            sync_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms));
+            sync_once();
+        }
+    }
+
+    void sync_once() {
+        uint64_t cursor = meta_ptr_->write_cursor.load(std::memory_order_acquire);
+        uint64_t synced = meta_ptr_->synced_cursor.load(std::memory_order_relaxed);
+        if (cursor <= synced) return;
+
+        // 按路径打开，不依赖写线程的映射 (写线程换段时会 munmap)；fdatasync 同样会写回 mmap 弄脏的页
+        for (uint64_t index = synced / capacity_; index <= (cursor - 1) / capacity_; ++index) {
+            sync_file(mmap_segment_path(base_path_, index));
+            if (framed_) sync_file(mmap_frame_path(base_path_, index));
+        }
+        meta_ptr_->synced_cursor.store(cursor, std::memory_order_release);
+        msync(meta_ptr_, sizeof(MetaHeader), MS_SYNC);
+    }
+
+    static void sync_file(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        fdatasync(fd);
+        close(fd);
+    }
+
+    std::string base_path_;
+    MemoryPolicy policy_;
+    uint64_t capacity_ = 0;
+    bool framed_ = false;
+    Segment cur_;
+    Segment next_;                // 预创建的下一段，仅在 join 预创建线程后访问
+    uint64_t segment_index_ = 0;
+    uint64_t segment_base_ = 0;   // 当前分段第一条记录的逻辑序号
+    std::thread preparer_;
+    std::thread syncer_;
+    std::mutex sync_mutex_;
+    std::condition_variable sync_cv_;
+    bool stopping_ = false;
     MetaHeader* meta_ptr_ = nullptr;
 };
 
+// ---------------------------------------------------------
+// Mmap 多生产者写入器 (可跨进程，多个柜台前置写同一个日志)
+// 生产者用 fetch_add 预留槽位，写入记录后在该分段的 .seq 文件中写入提交序号 (槽位序号 + 1)，
+// 再尝试把 write_cursor 推进到第一个未提交的槽位 (互相帮助推进)。write_cursor 始终是连续已提交的前缀，
+// 因此 MmapReader 无需改动即停在第一个未提交的槽位上。
+// 注意：生产者在预留后、提交前崩溃 (或切换分段失败) 会让日志停在该槽位，停止写入后用
+// hft_fsck --repair 压实 (journal_compact_reserved)；同一日志不能再用 MmapWriter 写入。
+// ---------------------------------------------------------
+template <typename T>
+class MmapMultiWriter {
+public:
+    // capacity: 单个分段能够存储的记录数 (已有文件时沿用文件中的分段大小)
+    MmapMultiWriter(const std::string& base_path, uint64_t capacity, const MemoryPolicy& policy = MemoryPolicy{})
+        : base_path_(base_path), policy_(policy) {
+        meta_ptr_ = mmap_meta_for_write(base_path);
+
+        if (meta_ptr_->flags & JOURNAL_FLAG_FRAMED) {
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            throw std::runtime_error("带记录帧的日志只能用 MmapWriter 写入: " + base_path);
+        }
+        if (meta_ptr_->flags & JOURNAL_FLAG_CIRCULAR) {
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            throw std::runtime_error("循环日志只能用 CircularWriter 写入: " + base_path);
+        }
+        // 多个生产者可能同时初始化，容量只由第一个写入。新日志先登记布局再发布容量，
+        // 看到容量非 0 的生产者必然也看到登记；容量非 0 而未登记的只能是旧日志
+        if (__atomic_load_n(&meta_ptr_->capacity, __ATOMIC_ACQUIRE) == 0) journal_stamp_layout<T>(meta_ptr_);
+        uint64_t expected = 0;
+        __atomic_compare_exchange_n(&meta_ptr_->capacity, &expected, capacity, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+        capacity_ = meta_ptr_->capacity;
+        std::string reason = journal_layout_mismatch<T>(meta_ptr_);
+        if (!reason.empty()) {
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            throw journal_layout_error(reason, base_path);
+        }
+        if (meta_ptr_->magic.load() == 0) journal_stamp_layout<T>(meta_ptr_); // 按 TickRecordV1 续写旧日志
+
+        // 新日志或单生产者日志：由抢到的生产者从 write_cursor 开始接管预留游标
+        uint32_t mode = JOURNAL_SINGLE_PRODUCER;
+        if (meta_ptr_->mode.compare_exchange_strong(mode, JOURNAL_CONVERTING)) {
+            meta_ptr_->reserve_cursor.store(meta_ptr_->write_cursor.load());
+            if (meta_ptr_->segments.load() == 0 && meta_ptr_->write_cursor.load() > 0) meta_ptr_->segments = 1;
+            meta_ptr_->mode.store(JOURNAL_MULTI_PRODUCER, std::memory_order_release);
+        }
+        while (meta_ptr_->mode.load(std::memory_order_acquire) == JOURNAL_CONVERTING) _mm_pause();
+
+        // 映射预留游标所在分段 (其他生产者可能正在写，不做预缺页)，并预创建下一段
+        uint64_t index = meta_ptr_->reserve_cursor.load() / capacity_;
+        cur_ = create_segment(index, MemoryPolicy{});
+        segment_base_ = index * capacity_;
+        prepare_next();
+    }
+
+    ~MmapMultiWriter() {
+        if (preparer_.joinable()) preparer_.join();
+        release(next_);
+        release(cur_);
+        if (help_seq_) munmap(help_seq_, seq_bytes());
+        if (meta_ptr_) munmap(meta_ptr_, sizeof(MetaHeader));
+    }
+
+    MmapMultiWriter(const MmapMultiWriter&) = delete;
+    MmapMultiWriter& operator=(const MmapMultiWriter&) = delete;
+
+    bool write(const T& record) {
+        // 1. 预留槽位
+        uint64_t n = meta_ptr_->reserve_cursor.fetch_add(1, std::memory_order_relaxed);
+        uint64_t offset = n - segment_base_;
+        if (offset >= capacity_) {
+            // 槽位在后续分段：切换映射 (失败时该槽位无法提交，日志会停在这里，需 hft_fsck --repair)
+            if (!switch_to(n / capacity_)) return false;
+            offset = n - segment_base_;
+        }
+
+        // 2. 写入记录，再提交 (提交序号 = 槽位序号 + 1，0 表示空槽)
+        cur_.data[offset] = record;
+        cur_.seq[offset].store(n + 1, std::memory_order_seq_cst);
+
+        // 3. 推进连续已提交前缀，并按需唤醒读者
+        publish_prefix();
+        return true;
+    }
+
+private:
+    struct Segment {
+        T* data = nullptr;
+        std::atomic<uint64_t>* seq = nullptr;
+        uint64_t index = UINT64_MAX;
+    };
+
+    size_t data_bytes() const { return capacity_ * sizeof(T); }
+    size_t seq_bytes() const { return capacity_ * sizeof(uint64_t); }
+
+    // 多个进程同时创建同一分段是安全的：ftruncate 到相同大小不会改动已有内容。
+    // 预缺页用 MADV_POPULATE_WRITE 不改内容；旧内核上的 MAP_POPULATE 重新映射只影响本进程的映射
+    Segment create_segment(uint64_t index, const MemoryPolicy& policy) {
+        Segment seg;
+        seg.data = static_cast<T*>(
+            mmap_file(mmap_segment_path(base_path_, index), data_bytes(), true, true, policy));
+        try {
+            seg.seq = static_cast<std::atomic<uint64_t>*>(
+                mmap_file(mmap_commit_path(base_path_, index), seq_bytes(), true, true, policy));
+        } catch (...) {
+            munmap(seg.data, data_bytes());
+            throw;
+        }
+        seg.index = index;
+
+        uint64_t count = meta_ptr_->segments.load(std::memory_order_relaxed);
+        while (count < index + 1 &&
+               !meta_ptr_->segments.compare_exchange_weak(count, index + 1, std::memory_order_release)) {
+        }
+        return seg;
+    }
+
+    void release(Segment& seg) {
+        if (seg.data) munmap(seg.data, data_bytes());
+        if (seg.seq) munmap(seg.seq, seq_bytes());
+        seg = Segment{};
+    }
+
+    void prepare_next() {
+        uint64_t index = cur_.index + 1;
+        preparer_ = std::thread([this, index] {
+            try {
+                next_ = create_segment(index, policy_);
+            } catch (const std::exception& e) {
+                std::cerr << "[Mmap] 预创建分段失败: " << e.what() << std::endl;
+                next_ = Segment{};
+            }
+        });
+    }
+
+    // 切换到第 index 段；其他生产者推进较快时可能跳过若干段，此时直接映射目标段
+    bool switch_to(uint64_t index) {
+        if (preparer_.joinable()) preparer_.join();
+        Segment seg;
+        if (next_.data && next_.index == index) {
+            seg = next_;
+            next_ = Segment{};
+        } else {
+            release(next_);
+            try {
+                seg = create_segment(index, policy_);
+            } catch (const std::exception& e) {
+                std::cerr << "[Mmap] 创建分段失败: " << e.what() << std::endl;
+                return false;
+            }
+        }
+
+        release(cur_);
+        cur_ = seg;
+        segment_base_ = index * capacity_;
+        prepare_next();
+        return true;
+    }
+
+    // 第 w 个槽位的提交序号；不在当前分段时 (分段边界、本生产者落后) 临时映射该段的 .seq 文件
+    const std::atomic<uint64_t>* slot_seq(uint64_t w) {
+        uint64_t index = w / capacity_;
+        if (index == cur_.index) return &cur_.seq[w - segment_base_];
+        if (index != help_index_) {
+            if (help_seq_) munmap(help_seq_, seq_bytes());
+            help_seq_ = nullptr;
+            help_index_ = UINT64_MAX;
+            try {
+                help_seq_ = static_cast<std::atomic<uint64_t>*>(
+                    mmap_file(mmap_commit_path(base_path_, index), seq_bytes(), false, false));
+                help_index_ = index;
+            } catch (const std::exception&) {
+                return nullptr; // 分段尚未创建，自然未提交
+            }
+        }
+        return &help_seq_[w - index * capacity_];
+    }
+
+    // 把 write_cursor 推进到第一个未提交的槽位。提交与检查均为 seq_cst：
+    // 任意两个相邻槽位的生产者，至少有一方会看到另一方的提交，前缀不会卡住
+    void publish_prefix() {
+        uint64_t w = meta_ptr_->write_cursor.load(std::memory_order_seq_cst);
+        for (;;) {
+            const std::atomic<uint64_t>* seq = slot_seq(w);
+            if (!seq || seq->load(std::memory_order_seq_cst) != w + 1) break;
+            // 失败时 w 被更新为最新值，继续检查
+            if (meta_ptr_->write_cursor.compare_exchange_weak(w, w + 1, std::memory_order_seq_cst)) w++;
+        }
+
+        if (meta_ptr_->waiters.load(std::memory_order_seq_cst) != 0) mmap_wake_readers(meta_ptr_);
+    }
+
+    std::string base_path_;
+    MemoryPolicy policy_;
+    uint64_t capacity_ = 0;
+    Segment cur_;
+    Segment next_;                // 预创建的下一段，仅在 join 预创建线程后访问
+    uint64_t segment_base_ = 0;   // 当前分段第一个槽位的逻辑序号
+    std::thread preparer_;
+    std::atomic<uint64_t>* help_seq_ = nullptr;
+    uint64_t help_index_ = UINT64_MAX;
+    MetaHeader* meta_ptr_ = nullptr;
+};
+
+// 映射区域内一段连续记录 (只读视图，不拥有数据)
+template <typename T>
+struct RecordSpan {
+    const T* data = nullptr;
+    size_t size = 0;
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+};
+
 // ---------------------------------------------------------
 // Mmap 读取器 (多消费者)
+// 按逻辑游标读取，跨过分段边界时自动映射下一段 (写者总是先创建分段再推进游标)
+// 没有新数据时可调用 wait() 按 WaitPolicy 等待；非 Spin 模式需要写元数据 (登记等待者)
+// memory 作用于数据分段：每映射一段，由后台线程预缺页、锁定，读线程不在分段切换时同步等待
 // ---------------------------------------------------------
 template <typename T>
 class MmapReader {
 public:
-    MmapReader(const std::string& base_path) {
-        std::string dat_path = base_path + ".dat";
-        std::string meta_path = base_path + ".meta";
-
-        // 1. 打开元数据 (只读)
-        int fd_meta = open(meta_path.c_str(), O_RDONLY);
-        if (fd_meta < 0) throw std::runtime_error("无法打开元数据文件: " + meta_path);
-        
-        meta_ptr_ = (MetaHeader*)mmap(nullptr, sizeof(MetaHeader), PROT_READ, MAP_SHARED, fd_meta, 0);
-        if (meta_ptr_ == MAP_FAILED) throw std::runtime_error("mmap 元数据文件失败");
-        close(fd_meta);
+    MmapReader(const std::string& base_path, WaitPolicy policy = WaitPolicy::Spin, uint32_t spin_count = 4096,
+               const MemoryPolicy& memory = MemoryPolicy{})
+        : base_path_(base_path), policy_(policy), spin_count_(spin_count), memory_(memory) {
+        // 1. 打开元数据 (Spin 模式只读；其余模式需要读写，无写权限时退化为 Spin)
+        meta_ptr_ = mmap_meta_for_read(base_path, policy_);
+
+        capacity_ = meta_ptr_->capacity;
+        std::string error;
+        if (capacity_ == 0) {
+            error = "元数据未初始化: " + base_path + ".meta";
+        } else if (meta_ptr_->flags & JOURNAL_FLAG_CIRCULAR) {
+            error = "循环日志只能用 CircularReader 读取: " + base_path;
+        }
+        if (!error.empty()) {
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            meta_ptr_ = nullptr;
+            throw std::runtime_error(error);
+        }
+
+        // 2. 校验记录格式：登记的大小/布局与当前 T 不一致时拒绝读取，避免按错误布局解释数据
+        std::string reason = journal_layout_mismatch<T>(meta_ptr_);
+        if (!reason.empty()) {
+            munmap(meta_ptr_, sizeof(MetaHeader));
+            meta_ptr_ = nullptr;
+            throw journal_layout_error(reason, base_path);
+        }
 
-        // 2. 打开数据 (只读)
-        int fd_dat = open(dat_path.c_str(), O_RDONLY);
-        if (fd_dat < 0) throw std::runtime_error("无法打开数据文件: " + dat_path);
-        
-        uint64_t dat_size = meta_ptr_->capacity * sizeof(T);
-        data_ptr_ = (T*)mmap(nullptr, dat_size, PROT_READ, MAP_SHARED, fd_dat, 0);
-        if (data_ptr_ == MAP_FAILED) throw std::runtime_error("mmap 数据文件失败");
-        close(fd_dat);
-        
-        local_cursor_ = 0; 
+        // 3. 映射第 0 段 (只读)
+        map_segment(0);
+        local_cursor_ = 0;
+    }
+
+    ~MmapReader() {
+        if (prefaulter_.joinable()) prefaulter_.join();
+        if (data_ptr_) munmap(data_ptr_, capacity_ * sizeof(T));
+        if (meta_ptr_) munmap(meta_ptr_, sizeof(MetaHeader));
     }
 
+    MmapReader(const MmapReader&) = delete;
+    MmapReader& operator=(const MmapReader&) = delete;
+
     bool read(T& out_record) {
         uint64_t w_cursor = meta_ptr_->write_cursor.load(std::memory_order_acquire);
-        
+
         if (local_cursor_ >= w_cursor) {
             return false;
         }
 
-        out_record = data_ptr_[local_cursor_];
+        uint64_t offset = locate(local_cursor_); // 可能重新映射，必须先于读取 data_ptr_
+        out_record = data_ptr_[offset];
         local_cursor_++;
         return true;
     }
 
+    // 零拷贝批量读取：只读一次游标，返回当前已就绪的连续记录 (最多 max_count 条，不跨分段)，
+    // 调用方直接在映射区域上处理，再用 commit(n) 推进。视图在下一次 peek_batch/read/seek 前有效。
+    RecordSpan<T> peek_batch(size_t max_count = SIZE_MAX) {
+        uint64_t w_cursor = meta_ptr_->write_cursor.load(std::memory_order_acquire);
+
+        if (local_cursor_ >= w_cursor) {
+            return {};
+        }
+
+        uint64_t offset = locate(local_cursor_);
+        uint64_t n = std::min<uint64_t>(w_cursor - local_cursor_, capacity_ - offset);
+        if (n > max_count) n = max_count;
+        return {data_ptr_ + offset, static_cast<size_t>(n)};
+    }
+
+    // 确认已处理 peek_batch 返回的前 n 条
+    void commit(size_t n) {
+        local_cursor_ += n;
+    }
+
+    // 是否有未读数据
+    bool available() const {
+        return local_cursor_ < meta_ptr_->write_cursor.load(std::memory_order_acquire);
+    }
+
+    // 等待新数据，最多等待 timeout；返回 true 表示已有数据可读
+    bool wait(std::chrono::microseconds timeout) {
+        return mmap_wait(meta_ptr_, policy_, spin_count_, timeout, [this] { return available(); });
+    }
+
     void seek_to_end() {
         local_cursor_ = meta_ptr_->write_cursor.load(std::memory_order_acquire);
     }
-    
+
     void seek_to_start() {
         local_cursor_ = 0;
     }
 
+    // 定位到第 n 条记录 (逻辑序号，配合 .idx 索引使用)
+    void seek(uint64_t n) {
+        local_cursor_ = n;
+    }
+
+    uint64_t position() const { return local_cursor_; }
+
+    // 随机访问第 n 条记录 (调用方保证 n 小于已写入条数)，不移动游标。
+    // 引用在下一次跨分段访问前有效
+    const T& at(uint64_t n) {
+        uint64_t offset = locate(n);
+        return data_ptr_[offset];
+    }
+
 private:
+    // 返回第 n 条记录在当前分段内的下标；不在当前分段 (跨过边界或 seek 过) 时重新映射，无符号回绕同样落入此分支
+    uint64_t locate(uint64_t n) {
+        uint64_t offset = n - segment_base_;
+        if (offset >= capacity_) {
+            map_segment(n / capacity_);
+            offset = n - segment_base_;
+        }
+        return offset;
+    }
+
+    void map_segment(uint64_t index) {
+        T* ptr = static_cast<T*>(
+            mmap_file(mmap_segment_path(base_path_, index), capacity_ * sizeof(T), false, false));
+        if (prefaulter_.joinable()) prefaulter_.join();
+        if (data_ptr_) munmap(data_ptr_, capacity_ * sizeof(T));
+        data_ptr_ = ptr;
+        segment_base_ = index * capacity_;
+
+        if (memory_.populate || memory_.lock || memory_.huge_pages) {
+            size_t len = capacity_ * sizeof(T);
+            MemoryPolicy memory = memory_;
+            prefaulter_ = std::thread([ptr, len, memory] { apply_memory_policy(ptr, len, memory, false); });
+        }
+    }
+
+    std::string base_path_;
+    WaitPolicy policy_;
+    uint32_t spin_count_;
+    MemoryPolicy memory_;
+    std::thread prefaulter_;       // 当前分段的后台预缺页，换段或析构前 join
+    uint64_t capacity_ = 0;
     T* data_ptr_ = nullptr;
+    uint64_t segment_base_ = 0;
     MetaHeader* meta_ptr_ = nullptr;
     uint64_t local_cursor_ = 0;
 };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+// Bounded multi-producer / single-consumer queue (Vyukov style).
+// Every cell carries a sequence number, so producers claim a slot with one CAS
+// on tail_ and publish it with a release store; the consumer never touches tail_.
+template <typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity) : mask_(capacity - 1), tail_(0), head_(0) {
+        // Capacity must be power of 2 for bitwise masking optimization
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("MpscQueue capacity must be power of 2");
+        }
+        cells_.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any producer: construct the item in place via fill(T&)
+    // Returns true if successful, false if full
+    template <typename Fill>
+    bool try_push(Fill&& fill) {
+        Cell* cell;
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            const size_t seq = cell->seq.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+
+        fill(cell->data);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool push(const T& item) {
+        return try_push([&item](T& slot) { slot = item; });
+    }
+
+    // Consumer only: hand the front item to consume(T&) without copying it out
+    // Returns true if successful, false if empty
+    template <typename Consume>
+    bool try_pop(Consume&& consume) {
+        Cell* cell = &cells_[head_ & mask_];
+        const size_t seq = cell->seq.load(std::memory_order_acquire);
+        if (seq != head_ + 1) {
+            return false; // Empty (or producer still filling)
+        }
+
+        consume(cell->data);
+        cell->seq.store(head_ + mask_ + 1, std::memory_order_release);
+        head_++;
+        return true;
+    }
+
+    bool pop(T& item) {
+        return try_pop([&item](T& slot) { item = slot; });
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    const size_t mask_;
+
+    // Padding to avoid false sharing between producers and the consumer
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;
+    alignas(CACHE_LINE_SIZE) size_t head_;
+};
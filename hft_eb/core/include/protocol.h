@@ -1,17 +1,19 @@
 #pragma once
 
 #include <cstdint>
+#include "record_layout.h"
 
 // 全字段行情记录，支持深度回测与因子计算
 struct TickRecord {
     // 基础信息
     char symbol[32];
     uint32_t trading_day; // YYYYMMDD
-    uint64_t update_time; // HHMMSSmmm
+    uint32_t instrument_id; // 共享合约表中的 ID (instrument_table.h)，0 表示未登记
+    int64_t exchange_time; // 交易所时间 (epoch ns，trading_calendar.h)，夜盘落在实际的自然日
+    int64_t local_time;    // 本地接收时间 (epoch ns)，与 exchange_time 之差为行情延迟
 
     // 价格与成交
     double last_price;
-    int volume;
     double turnover;      // 成交额
     double open_interest; // 持仓量
     
@@ -28,4 +30,25 @@ struct TickRecord {
     int bid_volume[5];
     double ask_price[5];
     int ask_volume[5];
+    int volume;           // 放在尾部的填充位，记录保持 256 字节
+};
+static_assert(sizeof(TickRecord) == 256, "TickRecord must stay 256 bytes");
+
+// 日志中登记的 TickRecord 布局；修改上面的字段时同步修改此列表，旧日志需用 hft_convert 迁移
+template <>
+struct RecordLayout<TickRecord> {
+    static constexpr const char* name = "TickRecord";
+    static constexpr FieldDesc fields[] = {
+        RECORD_FIELD(TickRecord, symbol),          RECORD_FIELD(TickRecord, trading_day),
+        RECORD_FIELD(TickRecord, instrument_id),   RECORD_FIELD(TickRecord, exchange_time),
+        RECORD_FIELD(TickRecord, local_time),      RECORD_FIELD(TickRecord, last_price),
+        RECORD_FIELD(TickRecord, turnover),        RECORD_FIELD(TickRecord, open_interest),
+        RECORD_FIELD(TickRecord, upper_limit),     RECORD_FIELD(TickRecord, lower_limit),
+        RECORD_FIELD(TickRecord, open_price),      RECORD_FIELD(TickRecord, highest_price),
+        RECORD_FIELD(TickRecord, lowest_price),    RECORD_FIELD(TickRecord, pre_close_price),
+        RECORD_FIELD(TickRecord, bid_price),       RECORD_FIELD(TickRecord, bid_volume),
+        RECORD_FIELD(TickRecord, ask_price),       RECORD_FIELD(TickRecord, ask_volume),
+        RECORD_FIELD(TickRecord, volume),
+    };
+    static constexpr uint64_t hash = layout_hash(fields, sizeof(TickRecord));
 };
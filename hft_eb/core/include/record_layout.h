@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// ---------------------------------------------------------
+// 记录布局描述：编译期根据字段名、偏移、大小与类型计算布局哈希，写入日志元数据。
+// 读取时与当前二进制的布局比对，结构体改动后旧文件不会被静默错读。
+// 新增/调整字段时必须同步更新对应的 RecordLayout 特化。
+// ---------------------------------------------------------
+struct FieldDesc {
+    const char* name;
+    size_t offset;
+    size_t size;
+    uint64_t type;
+};
+
+constexpr uint64_t layout_mix(uint64_t h, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        h ^= (v >> (i * 8)) & 0xFF;
+        h *= 1099511628211ull; // FNV-1a
+    }
+    return h;
+}
+
+constexpr uint64_t layout_mix(uint64_t h, const char* s) {
+    for (; *s; ++s) {
+        h ^= static_cast<unsigned char>(*s);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// 类型编码：区分有/无符号整数、浮点与数组长度，同样大小的 double -> int64_t 也能识别
+template <typename U>
+constexpr uint64_t layout_type_code() {
+    if constexpr (std::is_array_v<U>) {
+        return layout_mix(layout_type_code<std::remove_extent_t<U>>(), std::extent_v<U>);
+    } else if constexpr (std::is_floating_point_v<U>) {
+        return ('F' << 8) | sizeof(U);
+    } else if constexpr (std::is_integral_v<U>) {
+        return ((std::is_signed_v<U> ? 'I' : 'U') << 8) | sizeof(U);
+    } else {
+        return ('B' << 8) | sizeof(U);
+    }
+}
+
+template <size_t N>
+constexpr uint64_t layout_hash(const FieldDesc (&fields)[N], size_t record_size) {
+    uint64_t h = layout_mix(14695981039346656037ull, record_size);
+    for (size_t i = 0; i < N; ++i) {
+        h = layout_mix(h, fields[i].name);
+        h = layout_mix(h, fields[i].offset);
+        h = layout_mix(h, fields[i].size);
+        h = layout_mix(h, fields[i].type);
+    }
+    return h;
+}
+
+#define RECORD_FIELD(Type, field) \
+    FieldDesc{#field, offsetof(Type, field), sizeof(Type::field), layout_type_code<decltype(Type::field)>()}
+
+// 未声明布局的类型哈希为 0，只校验 sizeof
+template <typename T>
+struct RecordLayout {
+    static constexpr const char* name = "";
+    static constexpr uint64_t hash = 0;
+};
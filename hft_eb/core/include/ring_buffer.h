@@ -3,15 +3,59 @@
 #include <atomic>
 #include <vector>
 #include <cstddef>
+#include <utility>
 #include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include "mem_policy.h"
 
 // Cache line size (usually 64 bytes) to prevent false sharing
 #define CACHE_LINE_SIZE 64
 
+// Storage policies
+// InlineStorage: slots live inside the RingBuffer object (default)
+// MappedStorage: slots live in a separate anonymous mapping that honours a MemoryPolicy
+//                (prefault, mlock, huge pages), so the producer never page-faults on first touch
+struct InlineStorage {};
+struct MappedStorage {};
+
+namespace ring_detail {
+
+template <typename T, size_t Capacity, typename Storage>
+struct Slots;
+
+template <typename T, size_t Capacity>
+struct Slots<T, Capacity, InlineStorage> {
+    explicit Slots(const MemoryPolicy&) {}
+    T* data() { return buf; }
+    T buf[Capacity];
+};
+
 template <typename T, size_t Capacity>
+struct Slots<T, Capacity, MappedStorage> {
+    explicit Slots(const MemoryPolicy& policy) {
+        buf = static_cast<T*>(map_anonymous(sizeof(T) * Capacity, policy, &len));
+        for (size_t i = 0; i < Capacity; ++i) new (buf + i) T();
+    }
+    ~Slots() {
+        for (size_t i = 0; i < Capacity; ++i) buf[i].~T();
+        munmap(buf, len);
+    }
+    Slots(const Slots&) = delete;
+    Slots& operator=(const Slots&) = delete;
+    T* data() { return buf; }
+    T* buf = nullptr;
+    size_t len = 0;
+};
+
+} // namespace ring_detail
+
+template <typename T, size_t Capacity, typename Storage = InlineStorage>
 class RingBuffer {
 public:
-    RingBuffer() : head_(0), tail_(0) {
+    // policy only applies to MappedStorage
+    explicit RingBuffer(const MemoryPolicy& policy = MemoryPolicy{})
+        : head_(0), tail_(0), slots_(policy) {
         // Buffer size must be power of 2 for bitwise masking optimization
         static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be power of 2");
     }
@@ -26,7 +70,7 @@ public:
             return false; // Full
         }
 
-        buffer_[tail & (Capacity - 1)] = item;
+        slots_.data()[tail & (Capacity - 1)] = item;
         tail_.store(tail + 1, std::memory_order_release);
         return true;
     }
@@ -41,7 +85,8 @@ public:
             return false; // Empty
         }
 
-        item = buffer_[head & (Capacity - 1)];
+        // Move out so that owning elements (e.g. event references) are released promptly
+        item = std::move(slots_.data()[head & (Capacity - 1)]);
         head_.store(head + 1, std::memory_order_release);
         return true;
     }
@@ -52,5 +97,5 @@ private:
     alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;
     
     // Data storage
-    T buffer_[Capacity];
+    ring_detail::Slots<T, Capacity, Storage> slots_;
 };
@@ -0,0 +1,140 @@
+#pragma once
+#include "protocol.h"
+#include "mmap_util.h"
+#include "trading_calendar.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+// ---------------------------------------------------------
+// 行情日志的 .idx 索引 (由 hft_md/tools/build_index 离线生成)
+// 文件布局: [TickIndexHeader][TickIndexSymbol x N, 按合约名排序][TickIndexBucket x M][uint64_t 记录序号 x K]
+// - 合约表: 每个合约在记录序号数组中的区间，序号按日志顺序排列
+// - 时间桶: 按 exchange_time 粗分桶 (默认 1 秒)，每个非空桶记录首条记录的序号；时间戳跨零点连续，夜盘无需分段
+// 只覆盖建索引时已写入的 record_count 条，之后追加的记录需要顺序扫描
+// ---------------------------------------------------------
+static constexpr uint32_t TICK_INDEX_MAGIC = 0x58444954; // "TIDX"
+static constexpr uint32_t TICK_INDEX_VERSION = 2; // 2: 按 epoch 纳秒时间戳分桶
+
+struct TickIndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t record_count;    // 建索引时的 write_cursor
+    uint32_t bucket_ms;       // 时间桶宽度 (毫秒)
+    uint32_t symbol_count;
+    uint64_t bucket_count;
+    uint64_t symbols_offset;  // 各段在文件中的字节偏移
+    uint64_t buckets_offset;
+    uint64_t postings_offset;
+    char reserved[8];
+};
+static_assert(sizeof(TickIndexHeader) == 64, "TickIndexHeader must stay 64 bytes");
+
+struct TickIndexSymbol {
+    char symbol[32];
+    uint64_t first; // 在记录序号数组中的起始下标
+    uint64_t count;
+};
+
+struct TickIndexBucket {
+    uint64_t key;          // exchange_time / 桶宽 (纳秒)
+    uint64_t first_record; // 桶内首条记录的序号
+};
+
+inline uint64_t tick_bucket_key(int64_t exchange_time, uint32_t bucket_ms) {
+    return static_cast<uint64_t>(exchange_time) / (bucket_ms * static_cast<uint64_t>(NS_PER_MS));
+}
+
+class TickIndex {
+public:
+    // 打开 <base_path>.idx (只读映射)
+    explicit TickIndex(const std::string& base_path) {
+        std::string path = base_path + ".idx";
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("无法打开索引文件: " + path);
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TickIndexHeader)) {
+            close(fd);
+            throw std::runtime_error("索引文件损坏: " + path);
+        }
+        size_ = st.st_size;
+
+        base_ = static_cast<const char*>(mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0));
+        close(fd);
+        if (base_ == MAP_FAILED) throw std::runtime_error("mmap 索引文件失败: " + path);
+
+        header_ = reinterpret_cast<const TickIndexHeader*>(base_);
+        if (header_->magic != TICK_INDEX_MAGIC || header_->version != TICK_INDEX_VERSION ||
+            header_->postings_offset + header_->record_count * sizeof(uint64_t) > size_) {
+            munmap(const_cast<char*>(base_), size_);
+            throw std::runtime_error("索引文件格式不匹配: " + path);
+        }
+        symbols_ = reinterpret_cast<const TickIndexSymbol*>(base_ + header_->symbols_offset);
+        buckets_ = reinterpret_cast<const TickIndexBucket*>(base_ + header_->buckets_offset);
+        postings_ = reinterpret_cast<const uint64_t*>(base_ + header_->postings_offset);
+    }
+
+    ~TickIndex() {
+        munmap(const_cast<char*>(base_), size_);
+    }
+
+    TickIndex(const TickIndex&) = delete;
+    TickIndex& operator=(const TickIndex&) = delete;
+
+    uint64_t record_count() const { return header_->record_count; }
+
+    // 某合约的全部记录序号 (按日志顺序)，O(log n)；不存在时返回空
+    RecordSpan<uint64_t> symbol(const char* name) const {
+        const TickIndexSymbol* end = symbols_ + header_->symbol_count;
+        const TickIndexSymbol* it = std::lower_bound(symbols_, end, name,
+            [](const TickIndexSymbol& s, const char* n) { return strncmp(s.symbol, n, sizeof(s.symbol)) < 0; });
+        if (it == end || strncmp(it->symbol, name, sizeof(it->symbol)) != 0) return {};
+        return {postings_ + it->first, static_cast<size_t>(it->count)};
+    }
+
+    // 某合约 exchange_time 落在 [from, to] 内的记录序号，两次二分 O(log n)，之后顺序遍历 k 条
+    RecordSpan<uint64_t> symbol_range(MmapReader<TickRecord>& reader, const char* name,
+                                      int64_t from, int64_t to) const {
+        RecordSpan<uint64_t> all = symbol(name);
+        const uint64_t* lo = std::partition_point(all.begin(), all.end(),
+            [&](uint64_t n) { return reader.at(n).exchange_time < from; });
+        const uint64_t* hi = std::partition_point(lo, all.end(),
+            [&](uint64_t n) { return reader.at(n).exchange_time <= to; });
+        return {lo, static_cast<size_t>(hi - lo)};
+    }
+
+    // 粗定位：第一条 exchange_time 可能 >= t 的记录序号 (所在时间桶的首条记录)
+    uint64_t bucket_start(int64_t exchange_time) const {
+        uint64_t key = tick_bucket_key(exchange_time, header_->bucket_ms);
+        const TickIndexBucket* end = buckets_ + header_->bucket_count;
+        const TickIndexBucket* it = std::upper_bound(buckets_, end, key,
+            [](uint64_t k, const TickIndexBucket& b) { return k < b.key; });
+        return it == buckets_ ? 0 : (it - 1)->first_record;
+    }
+
+    // 把读取器定位到第一条 exchange_time >= t 的记录：先二分时间桶，再在桶内顺序跳过
+    void seek_to_time(MmapReader<TickRecord>& reader, int64_t exchange_time) const {
+        reader.seek(bucket_start(exchange_time));
+        for (auto batch = reader.peek_batch(); !batch.empty(); batch = reader.peek_batch()) {
+            size_t skip = 0;
+            while (skip < batch.size && batch.data[skip].exchange_time < exchange_time) skip++;
+            reader.commit(skip);
+            if (skip < batch.size) return;
+        }
+    }
+
+private:
+    const char* base_ = nullptr;
+    size_t size_ = 0;
+    const TickIndexHeader* header_ = nullptr;
+    const TickIndexSymbol* symbols_ = nullptr;
+    const TickIndexBucket* buckets_ = nullptr;
+    const uint64_t* postings_ = nullptr;
+};
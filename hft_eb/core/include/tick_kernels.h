@@ -0,0 +1,143 @@
+#pragma once
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ---------------------------------------------------------
+// 列式行情 (tick_store.h) 上的常用归约：VWAP、逐笔收益率、滚动最大/最小值。
+// 每个内核有标量与 AVX2 两个版本，AVX2 版本用 target 属性单独编译，整个工程不需要 -mavx2；
+// tick_kernels() 在首次调用时按 CPU 是否支持 AVX2 选定一组函数指针，之后没有分支。
+// 两个版本的累加顺序不同，VWAP 结果可能在末位有差异；其余内核除 NaN 输入外结果一致
+// ---------------------------------------------------------
+struct TickKernels {
+    const char* name;
+    // 区间 [0, n) 的成交量加权均价：成交量取累计 volume 的逐笔增量 (负增量按 0 计)，无成交时返回 NaN
+    double (*vwap)(const double* price, const int32_t* cum_volume, size_t n);
+    // out[i] = price[i + 1] / price[i] - 1，共 n - 1 个
+    void (*returns)(const double* price, double* out, size_t n);
+    // out[i] = max / min(in[max(0, i - window + 1) .. i])，共 n 个；out 可以与 in 相同
+    void (*rolling_max)(const double* in, double* out, size_t n, size_t window);
+    void (*rolling_min)(const double* in, double* out, size_t n, size_t window);
+};
+
+namespace tick_kernels_detail {
+
+inline double vwap_scalar(const double* price, const int32_t* cum_volume, size_t n) {
+    double pv = 0, v = 0;
+    for (size_t i = 1; i < n; ++i) {
+        int32_t d = std::max(cum_volume[i] - cum_volume[i - 1], 0);
+        pv += price[i] * d;
+        v += d;
+    }
+    return v > 0 ? pv / v : NAN;
+}
+
+inline void returns_scalar(const double* price, double* out, size_t n) {
+    for (size_t i = 0; i + 1 < n; ++i) out[i] = price[i + 1] / price[i] - 1;
+}
+
+template <bool Max>
+inline double pick(double a, double b) { return Max ? std::max(a, b) : std::min(a, b); }
+
+// van Herk / Gil-Werman：按窗口长度分块，块内前缀极值写入 out、后缀极值写入 suffix，
+// 窗口 [i - w + 1, i] 最多跨两个块，结果为 max(suffix[i - w + 1], out[i])。与窗口长度无关，每个元素 3 次比较
+template <bool Max>
+inline void block_scans(const double* in, double* out, double* suffix, size_t n, size_t w) {
+    for (size_t b = 0; b < n; b += w) {
+        size_t e = std::min(n, b + w);
+        double acc = in[e - 1]; // 先做后缀：out 与 in 相同时前缀扫描会覆盖输入
+        for (size_t i = e; i-- > b;) suffix[i] = acc = pick<Max>(acc, in[i]);
+        acc = in[b];
+        for (size_t i = b; i < e; ++i) out[i] = acc = pick<Max>(acc, in[i]);
+    }
+}
+
+template <bool Max>
+inline void rolling_scalar(const double* in, double* out, size_t n, size_t window) {
+    if (n == 0) return;
+    window = std::max<size_t>(window, 1);
+    thread_local std::vector<double> suffix;
+    suffix.resize(n);
+    block_scans<Max>(in, out, suffix.data(), n, window);
+    for (size_t i = window - 1; i < n; ++i) out[i] = pick<Max>(suffix[i - window + 1], out[i]);
+}
+
+__attribute__((target("avx2"))) inline double vwap_avx2(const double* price, const int32_t* cum_volume, size_t n) {
+    __m256d pv0 = _mm256_setzero_pd(), pv1 = _mm256_setzero_pd();
+    __m256d v0 = _mm256_setzero_pd(), v1 = _mm256_setzero_pd();
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 1;
+    for (; i + 8 <= n; i += 8) {
+        __m128i d0 = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cum_volume + i)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(cum_volume + i - 1)));
+        __m128i d1 = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cum_volume + i + 4)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(cum_volume + i + 3)));
+        __m256d q0 = _mm256_cvtepi32_pd(_mm_max_epi32(d0, zero));
+        __m256d q1 = _mm256_cvtepi32_pd(_mm_max_epi32(d1, zero));
+        pv0 = _mm256_add_pd(pv0, _mm256_mul_pd(_mm256_loadu_pd(price + i), q0));
+        pv1 = _mm256_add_pd(pv1, _mm256_mul_pd(_mm256_loadu_pd(price + i + 4), q1));
+        v0 = _mm256_add_pd(v0, q0);
+        v1 = _mm256_add_pd(v1, q1);
+    }
+    alignas(32) double lanes[2][4];
+    _mm256_store_pd(lanes[0], _mm256_add_pd(pv0, pv1));
+    _mm256_store_pd(lanes[1], _mm256_add_pd(v0, v1));
+    double pv = lanes[0][0] + lanes[0][1] + lanes[0][2] + lanes[0][3];
+    double v = lanes[1][0] + lanes[1][1] + lanes[1][2] + lanes[1][3];
+    for (; i < n; ++i) {
+        int32_t d = std::max(cum_volume[i] - cum_volume[i - 1], 0);
+        pv += price[i] * d;
+        v += d;
+    }
+    return v > 0 ? pv / v : NAN;
+}
+
+__attribute__((target("avx2"))) inline void returns_avx2(const double* price, double* out, size_t n) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    size_t i = 0;
+    for (; i + 5 <= n; i += 4) {
+        __m256d r = _mm256_div_pd(_mm256_loadu_pd(price + i + 1), _mm256_loadu_pd(price + i));
+        _mm256_storeu_pd(out + i, _mm256_sub_pd(r, one));
+    }
+    for (; i + 1 < n; ++i) out[i] = price[i + 1] / price[i] - 1;
+}
+
+template <bool Max>
+__attribute__((target("avx2"))) inline void rolling_avx2(const double* in, double* out, size_t n, size_t window) {
+    if (n == 0) return;
+    window = std::max<size_t>(window, 1);
+    thread_local std::vector<double> suffix;
+    suffix.resize(n);
+    block_scans<Max>(in, out, suffix.data(), n, window);
+    // 合并两路扫描是唯一与窗口跨块有关的部分，逐 4 个并行
+    size_t i = window - 1;
+    for (; i + 4 <= n; i += 4) {
+        __m256d s = _mm256_loadu_pd(suffix.data() + i - window + 1);
+        __m256d p = _mm256_loadu_pd(out + i);
+        _mm256_storeu_pd(out + i, Max ? _mm256_max_pd(s, p) : _mm256_min_pd(s, p));
+    }
+    for (; i < n; ++i) out[i] = pick<Max>(suffix[i - window + 1], out[i]);
+}
+
+} // namespace tick_kernels_detail
+
+inline const TickKernels& tick_kernels_scalar() {
+    using namespace tick_kernels_detail;
+    static const TickKernels k{"scalar", vwap_scalar, returns_scalar, rolling_scalar<true>, rolling_scalar<false>};
+    return k;
+}
+
+// 调用前需确认 CPU 支持 AVX2 (__builtin_cpu_supports("avx2"))
+inline const TickKernels& tick_kernels_avx2() {
+    using namespace tick_kernels_detail;
+    static const TickKernels k{"avx2", vwap_avx2, returns_avx2, rolling_avx2<true>, rolling_avx2<false>};
+    return k;
+}
+
+inline const TickKernels& tick_kernels() {
+    static const TickKernels& k = __builtin_cpu_supports("avx2") ? tick_kernels_avx2() : tick_kernels_scalar();
+    return k;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "protocol.h"
+#include "record_layout.h"
+#include "instrument_table.h"
+#include "trading_calendar.h"
+#include <cstring>
+
+// ---------------------------------------------------------
+// 旧版 TickRecord 布局，供 hft_convert 迁移旧日志、tick_archive 读取旧归档。
+// 修改 TickRecord 时把旧定义保留为 TickRecordV<n>，并提供升级到当前布局的函数
+// ---------------------------------------------------------
+
+// V1: 加入 instrument_id 之前的布局，该位置原为填充字节
+struct TickRecordV1 {
+    char symbol[32];
+    uint32_t trading_day;
+    uint64_t update_time;
+    double last_price;
+    int volume;
+    double turnover;
+    double open_interest;
+    double upper_limit;
+    double lower_limit;
+    double open_price;
+    double highest_price;
+    double lowest_price;
+    double pre_close_price;
+    double bid_price[5];
+    int bid_volume[5];
+    double ask_price[5];
+    int ask_volume[5];
+};
+
+template <>
+struct RecordLayout<TickRecordV1> {
+    static constexpr const char* name = "TickRecordV1";
+    static constexpr FieldDesc fields[] = {
+        RECORD_FIELD(TickRecordV1, symbol),          RECORD_FIELD(TickRecordV1, trading_day),
+        RECORD_FIELD(TickRecordV1, update_time),     RECORD_FIELD(TickRecordV1, last_price),
+        RECORD_FIELD(TickRecordV1, volume),          RECORD_FIELD(TickRecordV1, turnover),
+        RECORD_FIELD(TickRecordV1, open_interest),   RECORD_FIELD(TickRecordV1, upper_limit),
+        RECORD_FIELD(TickRecordV1, lower_limit),     RECORD_FIELD(TickRecordV1, open_price),
+        RECORD_FIELD(TickRecordV1, highest_price),   RECORD_FIELD(TickRecordV1, lowest_price),
+        RECORD_FIELD(TickRecordV1, pre_close_price), RECORD_FIELD(TickRecordV1, bid_price),
+        RECORD_FIELD(TickRecordV1, bid_volume),      RECORD_FIELD(TickRecordV1, ask_price),
+        RECORD_FIELD(TickRecordV1, ask_volume),
+    };
+    static constexpr uint64_t hash = layout_hash(fields, sizeof(TickRecordV1));
+};
+
+// V2: 加入 instrument_id，时间仍为交易日 + 日内 HHMMSSmmm
+struct TickRecordV2 {
+    char symbol[32];
+    uint32_t trading_day;
+    uint32_t instrument_id;
+    uint64_t update_time;
+    double last_price;
+    int volume;
+    double turnover;
+    double open_interest;
+    double upper_limit;
+    double lower_limit;
+    double open_price;
+    double highest_price;
+    double lowest_price;
+    double pre_close_price;
+    double bid_price[5];
+    int bid_volume[5];
+    double ask_price[5];
+    int ask_volume[5];
+};
+
+template <>
+struct RecordLayout<TickRecordV2> {
+    static constexpr const char* name = "TickRecordV2";
+    static constexpr FieldDesc fields[] = {
+        RECORD_FIELD(TickRecordV2, symbol),          RECORD_FIELD(TickRecordV2, trading_day),
+        RECORD_FIELD(TickRecordV2, instrument_id),   RECORD_FIELD(TickRecordV2, update_time),
+        RECORD_FIELD(TickRecordV2, last_price),      RECORD_FIELD(TickRecordV2, volume),
+        RECORD_FIELD(TickRecordV2, turnover),        RECORD_FIELD(TickRecordV2, open_interest),
+        RECORD_FIELD(TickRecordV2, upper_limit),     RECORD_FIELD(TickRecordV2, lower_limit),
+        RECORD_FIELD(TickRecordV2, open_price),      RECORD_FIELD(TickRecordV2, highest_price),
+        RECORD_FIELD(TickRecordV2, lowest_price),    RECORD_FIELD(TickRecordV2, pre_close_price),
+        RECORD_FIELD(TickRecordV2, bid_price),       RECORD_FIELD(TickRecordV2, bid_volume),
+        RECORD_FIELD(TickRecordV2, ask_price),       RECORD_FIELD(TickRecordV2, ask_volume),
+    };
+    static constexpr uint64_t hash = layout_hash(fields, sizeof(TickRecordV2));
+};
+static_assert(sizeof(TickRecordV1) == sizeof(TickRecord) && sizeof(TickRecordV2) == sizeof(TickRecord),
+              "legacy layouts share the 256-byte record size");
+
+// V2 -> 当前布局：交易日 + 日内时间按交易日历换算为交易所时间戳，旧记录没有本地接收时间 (记为 0)
+inline void upgrade_tick_record(const TickRecordV2& in, TickRecord& out) {
+    TickRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    memcpy(rec.symbol, in.symbol, sizeof(rec.symbol));
+    rec.trading_day = in.trading_day;
+    rec.instrument_id = in.instrument_id;
+    rec.exchange_time = exchange_time_ns(in.trading_day, in.update_time);
+    rec.local_time = 0;
+    rec.last_price = in.last_price;
+    rec.volume = in.volume;
+    rec.turnover = in.turnover;
+    rec.open_interest = in.open_interest;
+    rec.upper_limit = in.upper_limit;
+    rec.lower_limit = in.lower_limit;
+    rec.open_price = in.open_price;
+    rec.highest_price = in.highest_price;
+    rec.lowest_price = in.lowest_price;
+    rec.pre_close_price = in.pre_close_price;
+    memcpy(rec.bid_price, in.bid_price, sizeof(rec.bid_price));
+    memcpy(rec.bid_volume, in.bid_volume, sizeof(rec.bid_volume));
+    memcpy(rec.ask_price, in.ask_price, sizeof(rec.ask_price));
+    memcpy(rec.ask_volume, in.ask_volume, sizeof(rec.ask_volume));
+    out = rec;
+}
+
+// V1 与 V2 只差 instrument_id 处的填充字节
+inline void upgrade_tick_record(const TickRecordV1& in, TickRecord& out) {
+    TickRecordV2 v2;
+    memcpy(&v2, &in, sizeof(v2));
+    v2.instrument_id = INSTRUMENT_NONE;
+    upgrade_tick_record(v2, out);
+}
@@ -0,0 +1,254 @@
+#pragma once
+#include "protocol.h"
+#include "mmap_util.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// ---------------------------------------------------------
+// 内存列式行情 (SoA)，供向量化回测与因子研究使用 (内核见 tick_kernels.h)。
+// 按 TickRecord 逐条扫描单个字段时每条要带过 256 字节，列式存放后只读需要的列。
+// 一个或多个按天日志 (按时间顺序) 载入后按合约拆分，每个合约的各列在同一块内存中、各自 64 字节对齐，
+// 合约内保持日志顺序，days 给出每个交易日在列中的区间 (累计成交量/成交额按交易日重置，跨日计算需分段)。
+// 构建分两遍，均按 1M 条一块并行：先统计每块内各合约的条数并求出写入位置，再各自把块内记录分散写入各列
+// ---------------------------------------------------------
+static constexpr size_t TICK_STORE_ALIGN = 64;
+
+struct TickDay {
+    uint32_t trading_day;
+    uint64_t begin; // 该交易日在合约各列中的区间 [begin, end)
+    uint64_t end;
+};
+
+struct SymbolTicks {
+    std::string symbol;
+    uint64_t count = 0;
+    std::vector<TickDay> days;
+
+    int64_t* exchange_time = nullptr;
+    int64_t* local_time = nullptr;
+    double* last_price = nullptr;
+    double* turnover = nullptr;
+    double* open_interest = nullptr;
+    int32_t* volume = nullptr; // 累计成交量
+    double* bid_price[5] = {};
+    double* ask_price[5] = {};
+    int32_t* bid_volume[5] = {};
+    int32_t* ask_volume[5] = {};
+
+    // 合约所有列共用的内存
+    std::unique_ptr<char, decltype(&free)> arena{nullptr, &free};
+    size_t bytes = 0;
+};
+
+class TickStore {
+public:
+    // base_paths 为按天日志的基础文件名 (按时间顺序)；threads 为 0 时取硬件线程数
+    explicit TickStore(const std::vector<std::string>& base_paths, unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        plan_chunks(base_paths);
+
+        // 1. 各块内的合约条数
+        std::vector<std::unordered_map<std::string, uint64_t>> chunk_counts(chunks_.size());
+        parallel(threads, [&](size_t c) {
+            for_each_record(chunks_[c], [&](const TickRecord& rec) {
+                chunk_counts[c][std::string(rec.symbol, strnlen(rec.symbol, sizeof(rec.symbol)))]++;
+            });
+        });
+
+        // 2. 合约按名称排序；每块内各合约的写入起点 = 之前各块该合约的条数之和
+        std::unordered_map<std::string, uint64_t> totals;
+        for (const auto& counts : chunk_counts) {
+            for (const auto& pair : counts) totals[pair.first] += pair.second;
+        }
+        std::vector<std::string> names;
+        for (const auto& pair : totals) names.push_back(pair.first);
+        std::sort(names.begin(), names.end());
+        symbols_.resize(names.size());
+        for (size_t s = 0; s < names.size(); ++s) {
+            symbols_[s].symbol = names[s];
+            symbols_[s].count = totals[names[s]];
+            by_name_.emplace(symbols_[s].symbol, static_cast<uint32_t>(s));
+            allocate(symbols_[s]);
+        }
+
+        std::vector<std::vector<uint64_t>> starts(chunks_.size(), std::vector<uint64_t>(names.size()));
+        std::vector<uint64_t> running(names.size(), 0);
+        for (size_t c = 0; c < chunks_.size(); ++c) {
+            if (c == 0 || chunks_[c].file != chunks_[c - 1].file) {
+                // 交易日的起点：该文件第一块的写入位置，文件中没有该合约时不登记
+                for (size_t s = 0; s < names.size(); ++s) {
+                    bool present = false;
+                    for (size_t k = c; k < chunks_.size() && chunks_[k].file == chunks_[c].file && !present; ++k) {
+                        present = chunk_counts[k].count(names[s]) > 0;
+                    }
+                    if (present) symbols_[s].days.push_back({files_[chunks_[c].file].trading_day, running[s], 0});
+                }
+            }
+            for (const auto& pair : chunk_counts[c]) {
+                uint32_t s = by_name_.at(pair.first);
+                starts[c][s] = running[s];
+                running[s] += pair.second;
+            }
+        }
+        for (SymbolTicks& sym : symbols_) {
+            for (size_t d = 0; d < sym.days.size(); ++d) {
+                sym.days[d].end = d + 1 < sym.days.size() ? sym.days[d + 1].begin : sym.count;
+            }
+        }
+
+        // 3. 分散写入各列 (块之间的写入区间互不重叠)
+        parallel(threads, [&](size_t c) {
+            std::vector<uint64_t>& cursor = starts[c];
+            for_each_record(chunks_[c], [&](const TickRecord& rec) {
+                uint32_t s = by_name_.find(std::string_view(rec.symbol, strnlen(rec.symbol, sizeof(rec.symbol))))->second;
+                store(symbols_[s], cursor[s]++, rec);
+            });
+        });
+
+        for (const SymbolTicks& sym : symbols_) {
+            record_count_ += sym.count;
+            bytes_ += sym.bytes;
+        }
+    }
+
+    TickStore(const TickStore&) = delete;
+    TickStore& operator=(const TickStore&) = delete;
+
+    size_t size() const { return symbols_.size(); }
+    const SymbolTicks& operator[](size_t i) const { return symbols_[i]; }
+    const SymbolTicks* begin() const { return symbols_.data(); }
+    const SymbolTicks* end() const { return symbols_.data() + symbols_.size(); }
+
+    // 按合约名查找，不存在时返回 nullptr
+    const SymbolTicks* find(std::string_view symbol) const {
+        auto it = by_name_.find(symbol);
+        return it == by_name_.end() ? nullptr : &symbols_[it->second];
+    }
+
+    uint64_t record_count() const { return record_count_; }
+    size_t bytes() const { return bytes_; }
+
+private:
+    struct FileInfo {
+        std::string path;
+        uint32_t trading_day;
+    };
+
+    struct Chunk {
+        uint32_t file;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    static constexpr uint64_t kChunkRecords = 1 << 20;
+
+    void plan_chunks(const std::vector<std::string>& base_paths) {
+        for (const std::string& path : base_paths) {
+            MmapReader<TickRecord> reader(path);
+            reader.seek_to_end();
+            uint64_t total = reader.position();
+            if (total == 0) continue;
+            uint32_t file = static_cast<uint32_t>(files_.size());
+            files_.push_back({path, reader.at(0).trading_day});
+            for (uint64_t n = 0; n < total; n += kChunkRecords) chunks_.push_back({file, n, std::min(total, n + kChunkRecords)});
+        }
+    }
+
+    // 每个块由工作线程各自打开读取器，映射互不影响
+    template <typename F>
+    void for_each_record(const Chunk& chunk, F&& f) const {
+        MmapReader<TickRecord> reader(files_[chunk.file].path);
+        reader.seek(chunk.begin);
+        for (uint64_t n = chunk.begin; n < chunk.end;) {
+            RecordSpan<TickRecord> batch = reader.peek_batch(chunk.end - n);
+            if (batch.empty()) throw std::runtime_error("日志在载入过程中被截断: " + files_[chunk.file].path);
+            for (const TickRecord& rec : batch) f(rec);
+            reader.commit(batch.size);
+            n += batch.size;
+        }
+    }
+
+    template <typename F>
+    void parallel(unsigned threads, F&& f) {
+        std::atomic<size_t> next{0};
+        std::exception_ptr error;
+        std::atomic<bool> failed{false};
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < std::min<size_t>(threads, chunks_.size()); ++t) {
+            workers.emplace_back([&] {
+                try {
+                    for (size_t c = next.fetch_add(1); c < chunks_.size() && !failed; c = next.fetch_add(1)) f(c);
+                } catch (...) {
+                    if (!failed.exchange(true)) error = std::current_exception();
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+        if (error) std::rethrow_exception(error);
+    }
+
+    // 各列依次排在同一块内存中，每列起点按 64 字节对齐
+    static void allocate(SymbolTicks& sym) {
+        const uint64_t n = std::max<uint64_t>(sym.count, 1);
+        char* base = nullptr;
+        size_t offset = 0;
+        auto take = [&](auto*& ptr) {
+            using T = std::remove_reference_t<decltype(*ptr)>;
+            ptr = base ? reinterpret_cast<T*>(base + offset) : nullptr;
+            offset += (n * sizeof(T) + TICK_STORE_ALIGN - 1) / TICK_STORE_ALIGN * TICK_STORE_ALIGN;
+        };
+        auto layout = [&] {
+            offset = 0;
+            take(sym.exchange_time);
+            take(sym.local_time);
+            take(sym.last_price);
+            take(sym.turnover);
+            take(sym.open_interest);
+            take(sym.volume);
+            for (int i = 0; i < 5; ++i) take(sym.bid_price[i]);
+            for (int i = 0; i < 5; ++i) take(sym.ask_price[i]);
+            for (int i = 0; i < 5; ++i) take(sym.bid_volume[i]);
+            for (int i = 0; i < 5; ++i) take(sym.ask_volume[i]);
+        };
+        layout(); // 先算总大小，再在分配好的内存上定位各列
+        sym.bytes = offset;
+        base = static_cast<char*>(std::aligned_alloc(TICK_STORE_ALIGN, sym.bytes));
+        if (!base) throw std::runtime_error("列式行情内存分配失败: " + sym.symbol);
+        sym.arena.reset(base);
+        layout();
+    }
+
+    static void store(SymbolTicks& sym, uint64_t k, const TickRecord& rec) {
+        sym.exchange_time[k] = rec.exchange_time;
+        sym.local_time[k] = rec.local_time;
+        sym.last_price[k] = rec.last_price;
+        sym.turnover[k] = rec.turnover;
+        sym.open_interest[k] = rec.open_interest;
+        sym.volume[k] = rec.volume;
+        for (int i = 0; i < 5; ++i) {
+            sym.bid_price[i][k] = rec.bid_price[i];
+            sym.ask_price[i][k] = rec.ask_price[i];
+            sym.bid_volume[i][k] = rec.bid_volume[i];
+            sym.ask_volume[i][k] = rec.ask_volume[i];
+        }
+    }
+
+    std::vector<FileInfo> files_;
+    std::vector<Chunk> chunks_;
+    std::vector<SymbolTicks> symbols_;
+    std::unordered_map<std::string_view, uint32_t> by_name_; // 键指向 symbols_ 中的名称
+    uint64_t record_count_ = 0;
+    size_t bytes_ = 0;
+};
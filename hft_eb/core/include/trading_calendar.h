@@ -0,0 +1,277 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ---------------------------------------------------------
+// 交易时间：行情时间戳统一为 int64 纳秒 (Unix epoch)，交易所为北京时间 (UTC+8，无夏令时)。
+// 交易日 T 覆盖 [上一个工作日 18:00, T 18:00)：夜盘 (含跨零点部分) 属于下一个交易日。
+// 节假日前交易所取消夜盘，因此夜盘所在的自然日总是交易日前一个工作日，不需要节假日表。
+// 按品种的交易时段在 TradingCalendar 中按交易日预先展开为时间戳区间，
+// K 线对齐、按时间定位与延迟计算都只是整数运算。
+// ---------------------------------------------------------
+static constexpr int64_t NS_PER_MS = 1000000;
+static constexpr int64_t NS_PER_SEC = 1000 * NS_PER_MS;
+static constexpr int64_t MS_PER_DAY = 86400 * 1000;
+static constexpr int64_t NS_PER_DAY = MS_PER_DAY * NS_PER_MS;
+static constexpr int64_t EXCHANGE_UTC_OFFSET_NS = 8 * 3600 * NS_PER_SEC;
+static constexpr int64_t NIGHT_BEGIN_MS = 18 * 3600 * 1000; // 此后为下一个交易日的夜盘
+static constexpr int64_t NIGHT_END_MS = 6 * 3600 * 1000;    // 此前为跨零点的夜盘
+
+// 1970-01-01 起的天数 <-> 公历日期 (H. Hinnant 算法)
+constexpr int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+inline uint32_t yyyymmdd_from_days(int64_t z) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const int64_t y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+    return static_cast<uint32_t>(y * 10000 + m * 100 + d);
+}
+
+constexpr int64_t days_from_yyyymmdd(uint32_t ymd) {
+    return days_from_civil(ymd / 10000, (ymd / 100) % 100, ymd % 100);
+}
+
+// 0 = 周日 ... 6 = 周六
+constexpr int64_t weekday_of(int64_t days) { return (days % 7 + 11) % 7; }
+
+constexpr int64_t prev_weekday(int64_t days) {
+    do { --days; } while (weekday_of(days) == 0 || weekday_of(days) == 6);
+    return days;
+}
+
+constexpr int64_t next_weekday(int64_t days) {
+    while (weekday_of(days) == 0 || weekday_of(days) == 6) ++days;
+    return days;
+}
+
+// HHMMSSmmm <-> 日内毫秒
+constexpr int64_t hhmmssmmm_to_ms(uint64_t t) {
+    return static_cast<int64_t>(t / 10000000 * 3600000 + (t / 100000) % 100 * 60000 + (t / 1000) % 100 * 1000 + t % 1000);
+}
+
+constexpr uint64_t ms_to_hhmmssmmm(int64_t ms) {
+    return static_cast<uint64_t>(ms / 3600000 * 10000000 + (ms / 60000) % 60 * 100000 + (ms / 1000) % 60 * 1000 + ms % 1000);
+}
+
+// 自然日 (天数) 00:00 北京时间的时间戳
+constexpr int64_t exchange_midnight_ns(int64_t days) { return days * NS_PER_DAY - EXCHANGE_UTC_OFFSET_NS; }
+
+// 交易日 + 交易所日内时间 (HHMMSSmmm，行情原始格式) -> 时间戳：
+// 18:00 以后在前一个工作日，06:00 以前在前一个工作日的次日，其余在交易日当天
+constexpr int64_t exchange_time_ns(uint32_t trading_day, uint64_t hhmmssmmm) {
+    const int64_t ms = hhmmssmmm_to_ms(hhmmssmmm);
+    int64_t days = days_from_yyyymmdd(trading_day);
+    if (ms >= NIGHT_BEGIN_MS) {
+        days = prev_weekday(days);
+    } else if (ms < NIGHT_END_MS) {
+        days = prev_weekday(days) + 1;
+    }
+    return exchange_midnight_ns(days) + ms * NS_PER_MS;
+}
+
+// 北京时间的自然日 (天数) 与日内毫秒
+inline int64_t exchange_days_of(int64_t ns) {
+    int64_t local = ns + EXCHANGE_UTC_OFFSET_NS;
+    return local >= 0 ? local / NS_PER_DAY : (local + 1) / NS_PER_DAY - 1;
+}
+
+inline int64_t exchange_ms_of_day(int64_t ns) {
+    return (ns + EXCHANGE_UTC_OFFSET_NS - exchange_days_of(ns) * NS_PER_DAY) / NS_PER_MS;
+}
+
+// 时间戳 -> HHMMSSmmm (打印、命令行参数)
+inline uint64_t exchange_hhmmssmmm(int64_t ns) { return ms_to_hhmmssmmm(exchange_ms_of_day(ns)); }
+
+// 时间戳所属的交易日 (exchange_time_ns 的逆运算)
+inline uint32_t trading_day_of(int64_t ns) {
+    int64_t days = exchange_days_of(ns);
+    if (exchange_ms_of_day(ns) >= NIGHT_BEGIN_MS) days++;
+    return yyyymmdd_from_days(next_weekday(days));
+}
+
+// 本地接收时间戳 (与交易所时间戳同为 epoch ns，二者之差即行情延迟，含两端时钟偏差)
+inline int64_t realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * NS_PER_SEC + ts.tv_nsec;
+}
+
+// ---------------------------------------------------------
+// 交易时段
+// ---------------------------------------------------------
+
+// 日内毫秒区间 [begin, end)；begin >= 18:00 的为夜盘，end <= begin 表示跨零点
+struct SessionRule {
+    int32_t begin_ms;
+    int32_t end_ms;
+};
+
+static constexpr uint32_t MAX_SESSIONS = 6;
+
+// 某个交易日展开后的时段 (时间戳)，offset 为此前各时段的累计交易时长
+struct TradingDaySessions {
+    struct Interval {
+        int64_t begin;
+        int64_t end;
+        int64_t offset;
+    };
+    uint32_t trading_day = 0;
+    uint32_t count = 0;
+    Interval intervals[MAX_SESSIONS] = {};
+
+    int64_t open() const { return intervals[0].begin; }
+    int64_t close() const { return intervals[count - 1].end; }
+    int64_t duration() const { return intervals[count - 1].offset + intervals[count - 1].end - intervals[count - 1].begin; }
+
+    bool contains(int64_t t) const {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (t < intervals[i].begin) return false;
+            if (t < intervals[i].end) return true;
+        }
+        return false;
+    }
+
+    // 开盘以来的交易时长：休市时间 (含集合竞价) 计到下一段开始，收盘后计为总时长
+    int64_t elapsed(int64_t t) const {
+        for (uint32_t i = 0; i < count; ++i) {
+            const Interval& s = intervals[i];
+            if (t < s.end) return s.offset + std::max<int64_t>(0, t - s.begin);
+        }
+        return duration();
+    }
+
+    // elapsed 的逆运算
+    int64_t at_elapsed(int64_t e) const {
+        for (uint32_t i = 0; i < count; ++i) {
+            const Interval& s = intervals[i];
+            if (e < s.offset + (s.end - s.begin)) return s.begin + std::max<int64_t>(0, e - s.offset);
+        }
+        return close();
+    }
+
+    // 按交易时长对齐的 K 线起点 (跨休市连续计时)：恰好在某段收盘时刻 (10:15:00.000、15:00:00.000) 的行情
+    // 归入该段最后一根，收盘后的行情归入全天最后一根
+    int64_t bar_start(int64_t t, int64_t interval) const {
+        int64_t e = duration() - 1;
+        for (uint32_t i = 0; i < count; ++i) {
+            const Interval& s = intervals[i];
+            if (t <= s.end) {
+                e = s.offset + std::max<int64_t>(0, t - s.begin) - (t == s.end);
+                break;
+            }
+        }
+        return at_elapsed(e / interval * interval);
+    }
+};
+
+// 按品种 (合约代码的字母前缀，au2606 -> au) 的交易时段，展开结果按 (品种, 交易日) 缓存，
+// 同一个交易日的所有合约共用一份；未登记的品种按整个交易日窗口 [前一工作日 18:00, 18:00) 处理
+class TradingCalendar {
+public:
+    TradingCalendar() {
+        static const SessionRule kDay[] = {{9 * 3600000, 10 * 3600000 + 15 * 60000},
+                                           {10 * 3600000 + 30 * 60000, 11 * 3600000 + 30 * 60000},
+                                           {13 * 3600000 + 30 * 60000, 15 * 3600000}};
+        static const SessionRule kIndex[] = {{9 * 3600000 + 30 * 60000, 11 * 3600000 + 30 * 60000},
+                                             {13 * 3600000, 15 * 3600000}};
+        static const SessionRule kBond[] = {{9 * 3600000 + 30 * 60000, 11 * 3600000 + 30 * 60000},
+                                            {13 * 3600000, 15 * 3600000 + 15 * 60000}};
+        const SessionRule night2300{21 * 3600000, 23 * 3600000};
+        const SessionRule night0100{21 * 3600000, 1 * 3600000};
+        const SessionRule night0230{21 * 3600000, 2 * 3600000 + 30 * 60000};
+
+        auto add = [&](const char* products, const SessionRule* night, const SessionRule* day, size_t day_count) {
+            std::vector<SessionRule> rules;
+            if (night) rules.push_back(*night);
+            rules.insert(rules.end(), day, day + day_count);
+            for (const char* p = products; *p;) {
+                const char* e = strchr(p, ' ');
+                if (!e) e = p + strlen(p);
+                rules_[std::string(p, e)] = rules;
+                p = *e ? e + 1 : e;
+            }
+        };
+        add("au ag sc", &night0230, kDay, 3);
+        add("cu al zn pb ni sn ss ao bc", &night0100, kDay, 3);
+        add("rb hc bu ru fu sp br nr lu "
+            "a b m y p c cs i j jm l v pp eg eb pg rr "
+            "CF SR TA MA RM OI FG SA PF PX SH CY",
+            &night2300, kDay, 3);
+        add("wr ec jd lh fb bb AP CJ UR PK SF SM", nullptr, kDay, 3);
+        add("IF IH IC IM", nullptr, kIndex, 2);
+        add("T TF TS TL", nullptr, kBond, 2);
+    }
+
+    // 覆盖或新增品种的交易时段 (按时间顺序，夜盘在前)；已展开的缓存随之作废
+    void set_sessions(const std::string& product, const std::vector<SessionRule>& rules) {
+        rules_[product] = std::vector<SessionRule>(rules.begin(), rules.begin() + std::min<size_t>(rules.size(), MAX_SESSIONS));
+        days_.clear();
+    }
+
+    static std::string product_of(const char* symbol) {
+        size_t n = 0;
+        while (n < 8 && ((symbol[n] >= 'a' && symbol[n] <= 'z') || (symbol[n] >= 'A' && symbol[n] <= 'Z'))) n++;
+        return std::string(symbol, n);
+    }
+
+    // 合约在某个交易日的时段。返回的引用在 set_sessions 之前一直有效，调用方可以按合约缓存
+    const TradingDaySessions& sessions(const char* symbol, uint32_t trading_day) {
+        std::string product = product_of(symbol);
+        auto rules = rules_.find(product);
+        std::string key = (rules == rules_.end() ? std::string() : product) + '@' + std::to_string(trading_day);
+        auto it = days_.find(key);
+        if (it != days_.end()) return it->second;
+        return days_.emplace(key, expand(rules == rules_.end() ? nullptr : &rules->second, trading_day)).first->second;
+    }
+
+    // 交易日 [first, last] 内每个工作日、每个已登记品种的时段一次性展开 (回测开始前调用，之后查询只读缓存)
+    void precompute(uint32_t first, uint32_t last) {
+        for (int64_t d = next_weekday(days_from_yyyymmdd(first)); d <= days_from_yyyymmdd(last); d = next_weekday(d + 1)) {
+            for (const auto& pair : rules_) sessions(pair.first.c_str(), yyyymmdd_from_days(d));
+        }
+    }
+
+private:
+    static TradingDaySessions expand(const std::vector<SessionRule>* rules, uint32_t trading_day) {
+        TradingDaySessions out;
+        out.trading_day = trading_day;
+        const int64_t day = days_from_yyyymmdd(trading_day);
+        const int64_t night = prev_weekday(day);
+        if (!rules) {
+            out.count = 1;
+            out.intervals[0] = {exchange_midnight_ns(night) + NIGHT_BEGIN_MS * NS_PER_MS,
+                                exchange_midnight_ns(day) + NIGHT_BEGIN_MS * NS_PER_MS, 0};
+            return out;
+        }
+        int64_t offset = 0;
+        for (const SessionRule& r : *rules) {
+            int64_t base = exchange_midnight_ns(r.begin_ms >= NIGHT_BEGIN_MS ? night : day);
+            int64_t begin = base + r.begin_ms * NS_PER_MS;
+            int64_t end = base + r.end_ms * NS_PER_MS + (r.end_ms <= r.begin_ms ? NS_PER_DAY : 0);
+            out.intervals[out.count++] = {begin, end, offset};
+            offset += end - begin;
+        }
+        return out;
+    }
+
+    std::unordered_map<std::string, std::vector<SessionRule>> rules_;
+    std::unordered_map<std::string, TradingDaySessions> days_;
+};
@@ -2,6 +2,9 @@
 #include "ring_buffer.h"
 #include "ThostFtdcMdApi.h"
 #include "mmap_util.h"
+#include "circular_journal.h"
+#include "hot_tick.h"
+#include "trading_calendar.h"
 #include <thread>
 #include <fstream>
 #include <vector>
@@ -20,6 +23,28 @@ class TickRecorder : public CThostFtdcMdSpi {
 public:
     TickRecorder(const std::string& config_path) : running_(false) {
         load_config(config_path);
+        // 行情缓冲放在独立映射中，按 mmap_* 配置预缺页/锁定/大页，CTP 回调线程首次写入时不再缺页。
+        // 缓冲中存放紧凑的 HotTick (128 字节)，合约名与静态字段在 instruments_ 中，写入线程再还原为 TickRecord
+        rb_ = std::make_unique<RingBuffer<HotTick, 65536, MappedStorage>>(memory_policy_);
+        // 合约表：共享时放在 /dev/shm，引擎与工具只读打开，行情记录携带其中的 instrument_id
+        if (registry_path_.empty()) {
+            instruments_ = std::make_unique<InstrumentTable>();
+        } else {
+            instruments_ = std::make_unique<InstrumentTable>(registry_path_, true);
+            std::cout << "[Recorder] Instrument registry: " << registry_path_ << " (" << instruments_->size()
+                      << " instruments)" << std::endl;
+        }
+        // 订阅前预登记全部合约：登记持有进程间锁、表满时失败，都不放在 CTP 回调线程上
+        for (const std::string& symbol : symbols_) {
+            if (instruments_->reserve(symbol.c_str()) == INSTRUMENT_NONE) {
+                std::cerr << "[Recorder] WARN: 合约表已满，" << symbol << " 的行情将被丢弃" << std::endl;
+            }
+        }
+        if (!live_path_.empty()) {
+            live_ = std::make_unique<CircularWriter<TickRecord>>(live_path_, live_capacity_, live_policy_, memory_policy_);
+            std::cout << "[Recorder] Live journal: " << live_path_ << " (" << live_->capacity() << " ticks, "
+                      << lap_policy_name(live_policy_) << ")" << std::endl;
+        }
     }
     
     virtual ~TickRecorder() { stop(); }
@@ -84,7 +109,14 @@ public:
 
     void OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *pData) override {
         if (!pData) return;
-        
+        const int64_t local_time = realtime_ns(); // 先取接收时间，不计入下面的字段拷贝
+        // 回调线程只做无锁查找，未预登记的合约直接丢弃 (不在回调中登记、不抛异常)
+        const uint32_t id = instruments_->find(pData->InstrumentID);
+        if (id == INSTRUMENT_NONE) {
+            unregistered_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
         TickRecord rec;
         memset(&rec, 0, sizeof(TickRecord));
         
@@ -118,21 +150,44 @@ public:
         rec.ask_price[3] = pData->AskPrice4; rec.ask_volume[3] = pData->AskVolume4;
         rec.ask_price[4] = pData->AskPrice5; rec.ask_volume[4] = pData->AskVolume5;
         
-        // 解析时间
+        // 解析时间：交易日 + 日内时间按交易日历换算为时间戳 (夜盘落在实际的自然日，ActionDay 各交易所口径不一，不使用)
         int hh, mm, ss;
+        uint64_t hhmmssmmm = 0;
         if (sscanf(pData->UpdateTime, "%d:%d:%d", &hh, &mm, &ss) == 3) {
-            rec.update_time = (static_cast<uint64_t>(hh) * 10000 + mm * 100 + ss) * 1000 + pData->UpdateMillisec;
+            hhmmssmmm = (static_cast<uint64_t>(hh) * 10000 + mm * 100 + ss) * 1000 + pData->UpdateMillisec;
+        }
+        rec.exchange_time = exchange_time_ns(trading_day_int_, hhmmssmmm);
+        rec.local_time = local_time;
+
+        // 静态字段有变化时先压入一条标记，写入线程按到达顺序取用，还原的记录不受之后更新的影响
+        InstrumentStatics statics{rec.upper_limit, rec.lower_limit, rec.open_price, rec.pre_close_price};
+        if (statics != arrived_statics_[id]) {
+            HotTick marker;
+            memset(&marker, 0, sizeof(marker));
+            marker.instrument_id = id | kStaticsMarker;
+            memcpy(marker.levels, &statics, sizeof(statics));
+            if (!rb_->push(marker)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            arrived_statics_[id] = statics;
         }
 
-        if (!rb_.push(rec)) {
-            // 记录丢失警告
+        HotTick hot;
+        to_hot_tick(rec, id, *instruments_, hot);
+        if (!rb_->push(hot)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
         }
     }
 
 private:
     struct WriterContext {
         std::unique_ptr<MmapWriter<TickRecord>> writer;
+        std::unique_ptr<MmapMultiWriter<TickRecord>> shared_writer; // shared_journal 模式
         uint32_t current_day = 0;
+
+        bool opened() const { return writer || shared_writer; }
+        bool write(const TickRecord& rec) { return writer ? writer->write(rec) : shared_writer->write(rec); }
     };
 
     void load_config(const std::string& config_path) {
@@ -154,6 +209,25 @@ private:
         if (doc.HasMember("user_id")) user_id_ = doc["user_id"].GetString();
         if (doc.HasMember("password")) password_ = doc["password"].GetString();
         if (doc.HasMember("output_path")) output_path_ = doc["output_path"].GetString();
+        // 多个录制进程 (不同前置) 写同一个按天日志
+        if (doc.HasMember("shared_journal")) shared_journal_ = doc["shared_journal"].GetBool();
+        // 内存策略，同时作用于行情缓冲与日志分段
+        if (doc.HasMember("mmap_populate")) memory_policy_.populate = doc["mmap_populate"].GetBool();
+        if (doc.HasMember("mmap_lock")) memory_policy_.lock = doc["mmap_lock"].GetBool();
+        if (doc.HasMember("mmap_huge_pages")) memory_policy_.huge_pages = doc["mmap_huge_pages"].GetBool();
+        // 盘中 IPC：定长循环日志 (通常放在 /dev/shm)，读者登记游标，套圈策略 block / drop / overrun
+        if (doc.HasMember("live_journal")) live_path_ = doc["live_journal"].GetString();
+        if (doc.HasMember("live_capacity")) live_capacity_ = doc["live_capacity"].GetUint64();
+        if (doc.HasMember("live_lap_policy") && !parse_lap_policy(doc["live_lap_policy"].GetString(), live_policy_)) {
+            throw std::runtime_error("FATAL: Unknown live_lap_policy in " + config_path);
+        }
+        // 只做 IPC 时可关闭按天日志
+        if (doc.HasMember("day_journal")) day_journal_ = doc["day_journal"].GetBool();
+        // 共享合约表路径，置空则使用进程私有表，此时日志中的 instrument_id 记为 0 (未登记)
+        if (doc.HasMember("instrument_registry")) registry_path_ = doc["instrument_registry"].GetString();
+        // 持久化：记录帧 (序号 + CRC32C) 与周期性批量落盘
+        if (doc.HasMember("journal_framed")) durability_.framed = doc["journal_framed"].GetBool();
+        if (doc.HasMember("journal_sync_ms")) durability_.sync_interval_ms = doc["journal_sync_ms"].GetUint();
         
         if (doc.HasMember("symbols") && doc["symbols"].IsArray()) {
             for (auto& s : doc["symbols"].GetArray()) {
@@ -162,26 +236,55 @@ private:
         }
     }
 
+    // 缓冲中的静态字段标记：instrument_id 带最高位，四个静态字段放在档位区域，仅在录制器内部使用
+    static constexpr uint32_t kStaticsMarker = 0x80000000u;
+    static_assert(sizeof(InstrumentStatics) <= sizeof(HotTick::levels), "静态字段标记放不进 HotTick 档位区域");
+
+    void handle(const HotTick& hot, TickRecord& rec) {
+        if (hot.instrument_id & kStaticsMarker) {
+            uint32_t id = hot.instrument_id & ~kStaticsMarker;
+            memcpy(&written_statics_[id], hot.levels, sizeof(InstrumentStatics));
+            instruments_->update_statics(id, written_statics_[id]); // 顺序锁写在写入线程上
+            return;
+        }
+        to_tick_record(hot, *instruments_, written_statics_[hot.instrument_id], rec);
+        save_to_file(rec);
+    }
+
     void writer_loop() {
+        HotTick hot;
+        TickRecord rec;
         while (running_) {
-            TickRecord rec;
-            if (rb_.pop(rec)) {
-                save_to_file(rec);
+            if (rb_->pop(hot)) {
+                handle(hot, rec);
             } else {
                 std::this_thread::sleep_for(std::chrono::milliseconds(1));
             }
         }
-        TickRecord rec;
-        while (rb_.pop(rec)) save_to_file(rec);
+        while (rb_->pop(hot)) handle(hot, rec);
+        report_page_faults();
+        if (dropped_ > 0 || unregistered_ > 0) {
+            std::cout << "[Recorder] Dropped ticks: buffer full " << dropped_ << ", unregistered " << unregistered_
+                      << std::endl;
+        }
+        if (live_ && live_->dropped() > 0) {
+            std::cout << "[Recorder] Live journal dropped " << live_->dropped() << " ticks (readers lapped)" << std::endl;
+        }
         global_ctx_.reset();
     }
 
-    void save_to_file(const TickRecord& rec) {
+    void save_to_file(TickRecord& rec) {
+        // 私有表的 ID 在进程外没有意义，不写出
+        if (!instruments_->shared()) rec.instrument_id = INSTRUMENT_NONE;
+        // Drop 策略下读者跟不上时丢弃，丢弃数记在读者表中，退出时汇总
+        if (live_) live_->write(rec);
+        if (!day_journal_) return;
+
         if (!global_ctx_) {
             global_ctx_ = std::make_unique<WriterContext>();
         }
 
-        if (!global_ctx_->writer || global_ctx_->current_day != rec.trading_day) {
+        if (!global_ctx_->opened() || global_ctx_->current_day != rec.trading_day) {
             fs::create_directories(output_path_);
 
             char date_str[16];
@@ -190,20 +293,35 @@ private:
             // 基础文件名，MmapWriter 会自动补全后缀
             std::string base_path = output_path_ + "/market_data_" + date_str;
             
+            report_page_faults();
             std::cout << "[Recorder] Switching Mmap file: " << base_path << std::endl;
             
-            // 预分配 500 万条记录 (约 1GB)
-            global_ctx_->writer = std::make_unique<MmapWriter<TickRecord>>(base_path, 5000000);
+            // 按 100 万条 (约 260MB) 分段，写满自动续接预创建的下一段
+            if (shared_journal_) {
+                global_ctx_->shared_writer =
+                    std::make_unique<MmapMultiWriter<TickRecord>>(base_path, 1 << 20, memory_policy_);
+            } else {
+                global_ctx_->writer =
+                    std::make_unique<MmapWriter<TickRecord>>(base_path, 1 << 20, memory_policy_, durability_);
+            }
             global_ctx_->current_day = rec.trading_day;
         }
 
-        if (global_ctx_->writer) {
-            if (!global_ctx_->writer->write(rec)) {
-                 std::cerr << "[Recorder] WARN: Mmap buffer full!" << std::endl;
+        if (global_ctx_->opened()) {
+            if (!global_ctx_->write(rec)) {
+                 std::cerr << "[Recorder] WARN: Mmap segment allocation failed, tick dropped!" << std::endl;
             }
         }
     }
 
+    // 写入线程自上次报告以来的缺页次数，用于验证 mmap_* 配置的效果
+    void report_page_faults() {
+        PageFaults now = thread_page_faults();
+        PageFaults delta = now - last_faults_;
+        last_faults_ = now;
+        std::cout << "[Recorder] Writer page faults: minor=" << delta.minor << " major=" << delta.major << std::endl;
+    }
+
     // 配置项
     std::string md_front_;
     std::string broker_id_;
@@ -211,9 +329,24 @@ private:
     std::string password_;
     std::vector<std::string> symbols_;
     std::string output_path_;
+    bool shared_journal_ = false;
+    MemoryPolicy memory_policy_;
+    JournalDurability durability_; // 仅单生产者日志支持
+    std::string live_path_;
+    uint64_t live_capacity_ = 1 << 16;
+    LapPolicy live_policy_ = LapPolicy::Overrun;
+    bool day_journal_ = true;
+    std::string registry_path_ = INSTRUMENT_TABLE_DEFAULT_PATH;
 
     CThostFtdcMdApi* md_api_ = nullptr;
-    RingBuffer<TickRecord, 65536> rb_;
+    std::unique_ptr<RingBuffer<HotTick, 65536, MappedStorage>> rb_;
+    std::unique_ptr<InstrumentTable> instruments_; // 启动时预登记，CTP 回调线程只查找，静态字段由写入线程更新
+    std::vector<InstrumentStatics> arrived_statics_ = std::vector<InstrumentStatics>(InstrumentTable::kCapacity); // 回调线程
+    std::vector<InstrumentStatics> written_statics_ = std::vector<InstrumentStatics>(InstrumentTable::kCapacity); // 写入线程
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> unregistered_{0};
+    std::unique_ptr<CircularWriter<TickRecord>> live_;
+    PageFaults last_faults_;
     std::thread writer_thread_;
     std::atomic<bool> running_;
     uint32_t trading_day_int_ = 0;
@@ -0,0 +1,164 @@
+#include "protocol.h"
+#include "mmap_util.h"
+#include "tick_archive.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// 只保留 RecordLayout 登记的字段 (填充字节清零，合约名截断到第一个 '\0'，instrument_id 不归档)，用于逐字段比对
+static TickRecord normalized(const TickRecord& rec) {
+    TickRecord out{};
+    for (const FieldDesc& f : RecordLayout<TickRecord>::fields) {
+        memcpy(reinterpret_cast<char*>(&out) + f.offset, reinterpret_cast<const char*>(&rec) + f.offset, f.size);
+    }
+    out.instrument_id = 0;
+    size_t len = strnlen(out.symbol, sizeof(out.symbol));
+    memset(out.symbol + len, 0, sizeof(out.symbol) - len);
+    return out;
+}
+
+// 归档工具：把已收盘的行情日志转换为列式压缩归档 <base>.arc (格式见 tick_archive.h)。
+// 主线程顺序读入一组块，工作线程并行编码，再按顺序写出；--verify 时重新解码并与原始日志逐字段比对
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <基础文件名(不带后缀)> [--threads N] [--block 条数] [--verify]" << std::endl;
+        return 1;
+    }
+
+    std::string base_path = argv[1];
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t block_records = 8192;
+    bool verify = false;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (strcmp(argv[i], "--block") == 0 && i + 1 < argc) {
+            block_records = std::max(1, std::stoi(argv[++i]));
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        }
+    }
+
+    try {
+        MmapReader<TickRecord> reader(base_path);
+
+        // 先写临时文件，完成后再改名，避免读者看到写了一半的归档
+        std::string path = base_path + ".arc";
+        std::string tmp_path = path + ".tmp";
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("无法创建归档文件: " + tmp_path);
+
+        ArchiveHeader header{};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<ArchiveBlock> blocks;
+        uint64_t offset = sizeof(header);
+        uint64_t total = 0;
+
+        const size_t group_blocks = threads * 8;
+        std::vector<TickRecord> group(group_blocks * block_records);
+        std::vector<std::vector<uint8_t>> encoded(group_blocks);
+        for (;;) {
+            // 1. 读入一组 (跨分段拷贝到连续缓冲)
+            size_t filled = 0;
+            for (auto batch = reader.peek_batch(group.size()); !batch.empty();
+                 batch = reader.peek_batch(group.size() - filled)) {
+                memcpy(static_cast<void*>(&group[filled]), batch.data, batch.size * sizeof(TickRecord));
+                filled += batch.size;
+                reader.commit(batch.size);
+                if (filled == group.size()) break;
+            }
+            if (filled == 0) break;
+
+            // 2. 并行编码
+            size_t count = (filled + block_records - 1) / block_records;
+            std::atomic<size_t> next{0};
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < std::min<size_t>(threads, count); ++t) {
+                workers.emplace_back([&] {
+                    for (size_t k = next.fetch_add(1); k < count; k = next.fetch_add(1)) {
+                        size_t n = std::min<size_t>(block_records, filled - k * block_records);
+                        encoded[k] = archive_encode_block(&group[k * block_records], n);
+                    }
+                });
+            }
+            for (auto& w : workers) w.join();
+
+            // 3. 顺序写出
+            for (size_t k = 0; k < count; ++k) {
+                uint32_t n = static_cast<uint32_t>(std::min<size_t>(block_records, filled - k * block_records));
+                out.write(reinterpret_cast<const char*>(encoded[k].data()), encoded[k].size());
+                blocks.push_back({offset, static_cast<uint32_t>(encoded[k].size()), n});
+                offset += encoded[k].size();
+            }
+            total += filled;
+            if (filled < group.size()) break;
+        }
+
+        header.magic = ARCHIVE_MAGIC;
+        header.version = ARCHIVE_VERSION;
+        header.layout_hash = RecordLayout<TickRecord>::hash;
+        header.record_count = total;
+        header.block_count = blocks.size();
+        header.blocks_offset = offset;
+        header.block_records = block_records;
+        out.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(ArchiveBlock));
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        if (!out) throw std::runtime_error("写入归档文件失败: " + tmp_path);
+        if (std::rename(tmp_path.c_str(), path.c_str()) != 0) throw std::runtime_error("重命名归档文件失败: " + path);
+
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        uint64_t raw = total * sizeof(TickRecord);
+        uint64_t archived = offset + blocks.size() * sizeof(ArchiveBlock);
+        std::cout << "归档完成: " << path << " | 记录 " << total << " | " << raw << " -> " << archived << " 字节 ("
+                  << (archived ? static_cast<double>(raw) / archived : 0) << "x) | 编码 " << sec << "s ("
+                  << (sec > 0 ? raw / sec / 1e9 : 0) << " GB/s, " << threads << " 线程)" << std::endl;
+
+        if (verify) {
+            // 多核时用后台线程并行解码，与回测读取时的配置一致
+            unsigned decode_threads = threads > 1 ? threads : 0;
+            TickArchiveReader archive(base_path, std::string(), decode_threads);
+            auto t1 = std::chrono::steady_clock::now();
+            uint64_t decoded = 0;
+            for (auto batch = archive.peek_batch(); !batch.empty(); batch = archive.peek_batch()) {
+                decoded += batch.size;
+                archive.commit(batch.size);
+            }
+            double dsec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+
+            archive.seek_to_start();
+            reader.seek_to_start();
+            uint64_t n = 0;
+            TickRecord a, b;
+            while (archive.read(a)) {
+                if (!reader.read(b) || memcmp(&a, &(b = normalized(b)), sizeof(TickRecord)) != 0) {
+                    std::cerr << "校验失败: 第 " << n << " 条不一致" << std::endl;
+                    return 2;
+                }
+                n++;
+            }
+            if (n != total) {
+                std::cerr << "校验失败: 归档 " << n << " 条，原始 " << total << " 条" << std::endl;
+                return 2;
+            }
+            std::cout << "校验通过: " << n << " 条逐字段一致 | 解码 " << dsec << "s ("
+                      << (dsec > 0 ? decoded * sizeof(TickRecord) / dsec / 1e9 : 0) << " GB/s 原始记录, "
+                      << decode_threads << " 个后台解码线程)" << std::endl;
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
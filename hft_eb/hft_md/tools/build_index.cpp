@@ -0,0 +1,92 @@
+#include "protocol.h"
+#include "mmap_util.h"
+#include "tick_index.h"
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+// 离线索引器：扫描行情日志，生成 <base>.idx (合约 -> 记录序号、时间桶 -> 首条记录)
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <基础文件名(不带后缀)> [时间桶毫秒数, 默认 1000]" << std::endl;
+        return 1;
+    }
+
+    std::string base_path = argv[1];
+    uint32_t bucket_ms = 1000;
+    if (argc > 2) bucket_ms = static_cast<uint32_t>(std::stoul(argv[2]));
+    if (bucket_ms == 0) bucket_ms = 1;
+
+    try {
+        MmapReader<TickRecord> reader(base_path);
+
+        std::map<std::string, std::vector<uint64_t>> postings;
+        std::vector<TickIndexBucket> buckets;
+        uint64_t n = 0;
+
+        for (auto batch = reader.peek_batch(); !batch.empty(); batch = reader.peek_batch()) {
+            for (const TickRecord& rec : batch) {
+                postings[std::string(rec.symbol, strnlen(rec.symbol, sizeof(rec.symbol)))].push_back(n);
+
+                // 桶键取单调递增的部分，乱序到达的记录归入当前桶，保证桶表可以二分
+                uint64_t key = tick_bucket_key(rec.exchange_time, bucket_ms);
+                if (buckets.empty() || key > buckets.back().key) {
+                    buckets.push_back({key, n});
+                }
+                n++;
+            }
+            reader.commit(batch.size);
+        }
+
+        TickIndexHeader header{};
+        header.magic = TICK_INDEX_MAGIC;
+        header.version = TICK_INDEX_VERSION;
+        header.record_count = n;
+        header.bucket_ms = bucket_ms;
+        header.symbol_count = static_cast<uint32_t>(postings.size());
+        header.bucket_count = buckets.size();
+        header.symbols_offset = sizeof(TickIndexHeader);
+        header.buckets_offset = header.symbols_offset + postings.size() * sizeof(TickIndexSymbol);
+        header.postings_offset = header.buckets_offset + buckets.size() * sizeof(TickIndexBucket);
+
+        // 先写临时文件再 rename，避免读者看到写了一半的索引
+        std::string path = base_path + ".idx";
+        std::string tmp_path = path + ".tmp";
+        std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!ofs) throw std::runtime_error("无法创建索引文件: " + tmp_path);
+
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        uint64_t first = 0;
+        for (const auto& pair : postings) { // std::map 已按合约名排序
+            TickIndexSymbol sym{};
+            strncpy(sym.symbol, pair.first.c_str(), sizeof(sym.symbol) - 1);
+            sym.first = first;
+            sym.count = pair.second.size();
+            first += sym.count;
+            ofs.write(reinterpret_cast<const char*>(&sym), sizeof(sym));
+        }
+        ofs.write(reinterpret_cast<const char*>(buckets.data()), buckets.size() * sizeof(TickIndexBucket));
+        for (const auto& pair : postings) {
+            ofs.write(reinterpret_cast<const char*>(pair.second.data()), pair.second.size() * sizeof(uint64_t));
+        }
+
+        ofs.close();
+        if (!ofs || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("写入索引文件失败: " + path);
+        }
+
+        std::cout << "索引完成: " << path << " | 记录 " << n << " | 合约 " << postings.size()
+                  << " | 时间桶 " << buckets.size() << " (" << bucket_ms << "ms)" << std::endl;
+
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include "instrument_table.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+// 共享合约表内容：ID、合约名、定点价格小数位数与静态字段。只读访问，可在录制/回放运行时随时执行
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : INSTRUMENT_TABLE_DEFAULT_PATH;
+    try {
+        InstrumentTable table(path, false);
+        std::cout << "合约表: " << path << " | 已登记 " << table.size() << " / " << InstrumentTable::kCapacity - 1
+                  << std::endl;
+        std::cout << "----------------------------------------------------------------" << std::endl;
+        std::cout << "  ID | 合约             | 位数 |       涨停 |       跌停 |       开盘 |       昨收" << std::endl;
+        std::cout << "----------------------------------------------------------------" << std::endl;
+        for (uint32_t id = 1; id < table.end(); ++id) {
+            const InstrumentStatic& entry = table.at(id);
+            InstrumentStatics s = table.statics(id);
+            // 预登记后尚未收到行情的合约还没有选定小数位数
+            uint32_t decimals = entry.price_decimals.load(std::memory_order_acquire);
+            std::string shown = decimals == INSTRUMENT_DECIMALS_UNSET ? "-" : std::to_string(decimals);
+            std::cout << std::setw(4) << id << " | " << std::left << std::setw(16) << entry.symbol << std::right
+                      << " | " << std::setw(4) << shown << " | " << std::setw(10) << s.upper_limit
+                      << " | " << std::setw(10) << s.lower_limit << " | " << std::setw(10) << s.open_price << " | "
+                      << std::setw(10) << s.pre_close_price << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
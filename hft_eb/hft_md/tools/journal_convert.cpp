@@ -0,0 +1,218 @@
+#include "protocol.h"
+#include "mmap_util.h"
+#include "instrument_table.h"
+#include "tick_record_legacy.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+// 日志格式迁移工具：把旧布局的日志并行转换为当前 TickRecord 布局的新日志。
+// 源日志按登记的布局哈希识别 (未登记布局的旧日志按 TickRecordV1，也可用 --from 指定)；
+// 所有分段预先映射，工作线程按块转换 (可选同时生成记录帧)，全部落盘后最后才发布 write_cursor。
+// --stamp 为未登记布局的旧日志就地登记其实际布局 TickRecordV1 (不会登记为当前布局，续写前仍需迁移)。
+// --registry 按共享合约表 (只读) 为记录补上 instrument_id，表中没有的合约保持 0。
+
+// 已知的源布局。修改 TickRecord 时，把旧定义保留在 tick_record_legacy.h 并加入此表
+struct SourceLayout {
+    const char* name;
+    uint32_t record_size;
+    uint64_t layout_hash;
+    void (*convert)(const void* src, TickRecord* dst, size_t n);
+};
+
+static void convert_identity(const void* src, TickRecord* dst, size_t n) {
+    memcpy(dst, src, n * sizeof(TickRecord));
+}
+
+template <typename Legacy>
+static void convert_legacy(const void* src, TickRecord* dst, size_t n) {
+    const Legacy* in = static_cast<const Legacy*>(src);
+    for (size_t i = 0; i < n; ++i) upgrade_tick_record(in[i], dst[i]);
+}
+
+static const SourceLayout kLayouts[] = {
+    {RecordLayout<TickRecord>::name, sizeof(TickRecord), RecordLayout<TickRecord>::hash, convert_identity},
+    {RecordLayout<TickRecordV2>::name, sizeof(TickRecordV2), RecordLayout<TickRecordV2>::hash, convert_legacy<TickRecordV2>},
+    {RecordLayout<TickRecordV1>::name, sizeof(TickRecordV1), RecordLayout<TickRecordV1>::hash, convert_legacy<TickRecordV1>},
+};
+
+static const SourceLayout* find_layout(const MetaHeader* meta, const std::string& from) {
+    for (const auto& layout : kLayouts) {
+        if (meta->magic.load() == JOURNAL_MAGIC) {
+            if (layout.record_size == meta->record_size && layout.layout_hash == meta->layout_hash) return &layout;
+        } else if (from.empty() ? strcmp(layout.name, JOURNAL_UNSTAMPED_LAYOUT) == 0 : from == layout.name) {
+            return &layout;
+        }
+    }
+    return nullptr;
+}
+
+static int stamp(const std::string& base_path) {
+    MetaHeader* meta = static_cast<MetaHeader*>(mmap_file(base_path + ".meta", sizeof(MetaHeader), true, false));
+    if (meta->capacity == 0) throw std::runtime_error("元数据未初始化");
+    if (meta->magic.load() != 0) {
+        std::string reason = journal_layout_mismatch<TickRecord>(meta);
+        std::cout << "已登记布局 " << meta->record_name << (reason.empty() ? " (与当前一致)" : " (" + reason + ")")
+                  << std::endl;
+        return reason.empty() ? 0 : 2;
+    }
+    // 未登记的文件都由登记之前的代码写入，只能是 TickRecordV1
+    journal_stamp_layout<TickRecordV1>(meta);
+    msync(meta, sizeof(MetaHeader), MS_SYNC);
+    std::cout << "已登记布局 " << RecordLayout<TickRecordV1>::name << ": " << base_path << "，请用 hft_convert 迁移到当前 "
+              << RecordLayout<TickRecord>::name << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "用法: " << argv[0] << " <源基础文件名> <目标基础文件名> [--threads N] [--segment 条数] [--framed] [--from 布局名] [--registry 合约表]"
+                  << std::endl;
+        std::cerr << "      " << argv[0] << " --stamp <基础文件名>   为未登记布局的旧日志登记其实际布局 (TickRecordV1)" << std::endl;
+        return 1;
+    }
+
+    try {
+        if (strcmp(argv[1], "--stamp") == 0) return stamp(argv[2]);
+
+        std::string src_path = argv[1];
+        std::string dst_path = argv[2];
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        uint64_t dst_capacity = 0;
+        bool framed = false;
+        std::string from;
+        std::unique_ptr<InstrumentTable> registry;
+        for (int i = 3; i < argc; ++i) {
+            if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                threads = std::max(1, std::stoi(argv[++i]));
+            } else if (strcmp(argv[i], "--segment") == 0 && i + 1 < argc) {
+                dst_capacity = std::stoull(argv[++i]);
+            } else if (strcmp(argv[i], "--framed") == 0) {
+                framed = true;
+            } else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+                from = argv[++i];
+            } else if (strcmp(argv[i], "--registry") == 0 && i + 1 < argc) {
+                registry = std::make_unique<InstrumentTable>(argv[++i], false);
+            }
+        }
+
+        // 1. 源日志：识别布局，映射全部分段
+        const MetaHeader* src_meta =
+            static_cast<const MetaHeader*>(mmap_file(src_path + ".meta", sizeof(MetaHeader), false, false));
+        const uint64_t src_capacity = src_meta->capacity;
+        const uint64_t total = src_meta->write_cursor.load();
+        if (src_capacity == 0) throw std::runtime_error("源元数据未初始化");
+        const SourceLayout* layout = find_layout(src_meta, from);
+        if (!layout) {
+            throw std::runtime_error(std::string("未知的源布局 ") +
+                                     (src_meta->magic.load() == JOURNAL_MAGIC ? src_meta->record_name : from.c_str()));
+        }
+        if (dst_capacity == 0) dst_capacity = src_capacity;
+
+        std::vector<const char*> src_segments;
+        for (uint64_t index = 0; index * src_capacity < total; ++index) {
+            src_segments.push_back(static_cast<const char*>(
+                mmap_file(mmap_segment_path(src_path, index), src_capacity * layout->record_size, false, false)));
+        }
+
+        // 2. 目标日志：必须是新文件；先创建全部分段，游标保持 0，转换完成前读者看不到任何记录
+        struct stat st;
+        if (stat((dst_path + ".meta").c_str(), &st) == 0) throw std::runtime_error("目标日志已存在: " + dst_path);
+        MetaHeader* dst_meta = mmap_meta_for_write(dst_path);
+        dst_meta->capacity = dst_capacity;
+        dst_meta->flags = framed ? JOURNAL_FLAG_FRAMED : 0;
+        journal_stamp_layout<TickRecord>(dst_meta);
+
+        const uint64_t dst_count = std::max<uint64_t>(1, (total + dst_capacity - 1) / dst_capacity);
+        std::vector<TickRecord*> dst_segments;
+        std::vector<RecordFrame*> dst_frames;
+        for (uint64_t index = 0; index < dst_count; ++index) {
+            dst_segments.push_back(static_cast<TickRecord*>(
+                mmap_file(mmap_segment_path(dst_path, index), dst_capacity * sizeof(TickRecord), true, true)));
+            if (framed) {
+                dst_frames.push_back(static_cast<RecordFrame*>(
+                    mmap_file(mmap_frame_path(dst_path, index), dst_capacity * sizeof(RecordFrame), true, true)));
+            }
+        }
+        dst_meta->segments = dst_count;
+
+        std::cout << "源: " << src_path << " (" << layout->name << ", " << layout->record_size << " 字节/条, "
+                  << total << " 条) -> 目标: " << dst_path << " (" << RecordLayout<TickRecord>::name << ", "
+                  << sizeof(TickRecord) << " 字节/条" << (framed ? ", 带记录帧" : "") << ")" << std::endl;
+
+        // 3. 按块并行转换；块内按源、目标分段边界切成连续区间
+        auto t0 = std::chrono::steady_clock::now();
+        const uint64_t chunk = 1 << 16;
+        const uint64_t chunks = (total + chunk - 1) / chunk;
+        std::atomic<uint64_t> next{0};
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                for (uint64_t k = next.fetch_add(1); k < chunks; k = next.fetch_add(1)) {
+                    uint64_t end = std::min(total, (k + 1) * chunk);
+                    for (uint64_t n = k * chunk; n < end;) {
+                        uint64_t src_off = n % src_capacity;
+                        uint64_t dst_off = n % dst_capacity;
+                        uint64_t run = std::min({end - n, src_capacity - src_off, dst_capacity - dst_off});
+                        TickRecord* dst = dst_segments[n / dst_capacity] + dst_off;
+                        layout->convert(src_segments[n / src_capacity] + src_off * layout->record_size, dst, run);
+                        if (registry) {
+                            for (uint64_t i = 0; i < run; ++i) dst[i].instrument_id = registry->find(dst[i].symbol);
+                        }
+                        if (framed) {
+                            RecordFrame* frames = dst_frames[n / dst_capacity] + dst_off;
+                            for (uint64_t i = 0; i < run; ++i) {
+                                frames[i] = RecordFrame{n + i + 1, crc32c(&dst[i], sizeof(TickRecord)), 0};
+                            }
+                        }
+                        n += run;
+                    }
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+        workers.clear();
+
+        // 4. 各分段并行落盘，再发布游标
+        std::atomic<uint64_t> next_segment{0};
+        for (unsigned t = 0; t < std::min<uint64_t>(threads, dst_count); ++t) {
+            workers.emplace_back([&] {
+                for (uint64_t index = next_segment.fetch_add(1); index < dst_count; index = next_segment.fetch_add(1)) {
+                    msync(dst_segments[index], dst_capacity * sizeof(TickRecord), MS_SYNC);
+                    if (framed) msync(dst_frames[index], dst_capacity * sizeof(RecordFrame), MS_SYNC);
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        dst_meta->synced_cursor.store(total);
+        dst_meta->write_cursor.store(total);
+        msync(dst_meta, sizeof(MetaHeader), MS_SYNC);
+
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "转换完成: " << total << " 条, 耗时 " << sec << "s ("
+                  << (sec > 0 ? total * layout->record_size / sec / 1e9 : 0) << " GB/s, " << threads << " 线程)"
+                  << std::endl;
+
+        for (uint64_t index = 0; index < src_segments.size(); ++index) {
+            munmap(const_cast<char*>(src_segments[index]), src_capacity * layout->record_size);
+        }
+        for (uint64_t index = 0; index < dst_count; ++index) {
+            munmap(dst_segments[index], dst_capacity * sizeof(TickRecord));
+            if (framed) munmap(dst_frames[index], dst_capacity * sizeof(RecordFrame));
+        }
+        munmap(dst_meta, sizeof(MetaHeader));
+        munmap(const_cast<MetaHeader*>(src_meta), sizeof(MetaHeader));
+
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "protocol.h"
+#include "mmap_util.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+// 日志校验/修复工具：多线程并行校验记录帧 (序号 + CRC32C)，找到第一条无效记录；
+// --repair 时把 write_cursor 截断到该位置。多生产者日志另外检查预留未提交的槽位，
+// --repair 时压实填补。修复前必须先停止写入进程。
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <基础文件名(不带后缀)> [--repair] [--threads N]" << std::endl;
+        return 1;
+    }
+
+    std::string base_path = argv[1];
+    bool repair = false;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--repair") == 0) {
+            repair = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        }
+    }
+
+    try {
+        MetaHeader* meta = static_cast<MetaHeader*>(
+            mmap_file(base_path + ".meta", sizeof(MetaHeader), repair, false));
+        const uint64_t capacity = meta->capacity;
+        const bool framed = (meta->flags & JOURNAL_FLAG_FRAMED) != 0;
+        if (capacity == 0) throw std::runtime_error("元数据未初始化");
+        if (meta->flags & JOURNAL_FLAG_CIRCULAR) throw std::runtime_error("循环日志只用于盘中 IPC，不支持校验/修复");
+        std::string reason = journal_layout_mismatch<TickRecord>(meta);
+        if (!reason.empty()) throw journal_layout_error(reason, base_path);
+
+        // 多生产者日志：预留后未提交的槽位会让 write_cursor 与所有读者停在该处
+        bool stuck = false;
+        if (meta->mode.load() == JOURNAL_MULTI_PRODUCER && meta->reserve_cursor.load() > meta->write_cursor.load()) {
+            uint64_t from = meta->write_cursor.load();
+            uint64_t to = meta->reserve_cursor.load();
+            uint64_t holes = journal_compact_reserved<TickRecord>(base_path, meta, false);
+            std::cout << "预留未发布: [" << from << ", " << to << ")，其中 " << holes << " 个槽位未提交" << std::endl;
+            if (!repair) {
+                std::cout << "使用 --repair 把已提交的记录前移填补空洞 (需先停止所有写入进程)" << std::endl;
+                stuck = true;
+            } else {
+                journal_compact_reserved<TickRecord>(base_path, meta, true);
+                msync(meta, sizeof(MetaHeader), MS_SYNC);
+                std::cout << "已压实，游标推进到 " << meta->write_cursor.load() << std::endl;
+            }
+        }
+        const uint64_t cursor = meta->write_cursor.load();
+
+        std::cout << "日志: " << base_path << " | 游标 " << cursor << " | 已落盘 " << meta->synced_cursor.load()
+                  << " | 分段容量 " << capacity << " | " << (framed ? "带记录帧" : "无记录帧") << std::endl;
+
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t first_invalid = cursor;
+
+        if (framed) {
+            // 按块并行校验，块内顺序扫描；已发现的最小失败位置之后的块直接跳过
+            const uint64_t chunk = 1 << 16;
+            const uint64_t chunks = (cursor + chunk - 1) / chunk;
+            std::atomic<uint64_t> next{0};
+            std::atomic<uint64_t> min_bad{cursor};
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&] {
+                    for (uint64_t k = next.fetch_add(1); k < chunks; k = next.fetch_add(1)) {
+                        uint64_t begin = k * chunk;
+                        if (begin >= min_bad.load(std::memory_order_relaxed)) continue;
+                        uint64_t end = std::min(cursor, begin + chunk);
+                        uint64_t bad = journal_first_invalid<TickRecord>(base_path, capacity, begin, end);
+                        if (bad == end) continue;
+                        uint64_t cur = min_bad.load();
+                        while (bad < cur && !min_bad.compare_exchange_weak(cur, bad)) {
+                        }
+                    }
+                });
+            }
+            for (auto& w : workers) w.join();
+            first_invalid = min_bad.load();
+        } else {
+            // 无记录帧时只能检查分段文件是否齐全
+            std::cout << "未启用记录帧，仅检查分段文件" << std::endl;
+            for (uint64_t index = 0; index * capacity < cursor; ++index) {
+                struct stat st;
+                if (stat(mmap_segment_path(base_path, index).c_str(), &st) != 0 ||
+                    static_cast<uint64_t>(st.st_size) < capacity * sizeof(TickRecord)) {
+                    first_invalid = index * capacity;
+                    break;
+                }
+            }
+        }
+
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "校验完成: " << first_invalid << " 条有效, 耗时 " << sec << "s ("
+                  << (sec > 0 ? first_invalid * sizeof(TickRecord) / sec / 1e9 : 0) << " GB/s, "
+                  << threads << " 线程)" << std::endl;
+
+        if (first_invalid == cursor) {
+            std::cout << "日志完整" << std::endl;
+            return stuck ? 2 : 0;
+        }
+
+        std::cout << "第一条无效记录: " << first_invalid << "，之后 " << (cursor - first_invalid) << " 条将被丢弃" << std::endl;
+        if (!repair) {
+            std::cout << "使用 --repair 截断 (需先停止写入进程)" << std::endl;
+            return 2;
+        }
+
+        meta->write_cursor.store(first_invalid);
+        if (meta->synced_cursor.load() > first_invalid) meta->synced_cursor.store(first_invalid);
+        msync(meta, sizeof(MetaHeader), MS_SYNC);
+        std::cout << "已截断到 " << first_invalid << std::endl;
+
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "protocol.h"
+#include "circular_journal.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+// 循环日志状态：写者游标、套圈策略与计数，以及每个已登记读者的游标、落后条数与被套圈情况。
+// 只读访问，可在录制/回放运行时随时执行
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <循环日志基础文件名>" << std::endl;
+        return 1;
+    }
+
+    std::string base_path = argv[1];
+    try {
+        const MetaHeader* meta =
+            static_cast<const MetaHeader*>(mmap_file(base_path + ".meta", sizeof(MetaHeader), false, false));
+        if (!(meta->flags & JOURNAL_FLAG_CIRCULAR)) throw std::runtime_error("不是循环日志: " + base_path);
+        const ReaderRegistry* registry = static_cast<const ReaderRegistry*>(
+            mmap_file(circular_registry_path(base_path), sizeof(ReaderRegistry), false, false));
+
+        const uint64_t cursor = meta->write_cursor.load();
+        const uint64_t capacity = meta->capacity;
+        std::cout << "日志: " << base_path << " | 游标 " << cursor << " | 容量 " << capacity << " 条 ("
+                  << capacity * meta->record_size / 1024 << " KB) | 策略 "
+                  << lap_policy_name(static_cast<LapPolicy>(registry->policy.load())) << " | 丢弃 "
+                  << registry->dropped.load() << " | 写者等待 " << registry->blocked.load() << " 次" << std::endl;
+
+        std::cout << "----------------------------------------------------------------" << std::endl;
+        std::cout << "槽位 | 读者                     | PID     | 游标         | 落后     | 套圈 | 丢失" << std::endl;
+        std::cout << "----------------------------------------------------------------" << std::endl;
+        uint32_t active = 0;
+        uint32_t high = std::min(registry->high_water.load(), CIRCULAR_MAX_READERS);
+        for (uint32_t i = 0; i < high; ++i) {
+            const ReaderSlot& slot = registry->slots[i];
+            if (slot.state.load() != READER_ACTIVE) continue;
+            uint64_t c = slot.cursor.load();
+            uint64_t lag = cursor > c ? cursor - c : 0;
+            std::cout << std::setw(4) << i << " | " << std::left << std::setw(24) << slot.name << std::right << " | "
+                      << std::setw(7) << slot.pid << (circular_reader_alive(slot) ? " " : "!") << "| " << std::setw(12)
+                      << c << " | " << std::setw(8) << lag << (lag >= capacity ? "*" : " ") << "| " << std::setw(4)
+                      << slot.overruns.load() << " | " << slot.lost.load() << std::endl;
+            active++;
+        }
+        std::cout << "----------------------------------------------------------------" << std::endl;
+        std::cout << "已登记读者: " << active << " (! 进程已退出, * 已被套圈)" << std::endl;
+
+        munmap(const_cast<ReaderRegistry*>(registry), sizeof(ReaderRegistry));
+        munmap(const_cast<MetaHeader*>(meta), sizeof(MetaHeader));
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,16 +1,18 @@
 #include "protocol.h"
+#include "mmap_util.h"
+#include "instrument_table.h"
+#include "trading_calendar.h"
 #include <iostream>
-#include <fstream>
 #include <vector>
 #include <string>
-#include <unordered_map>
 #include <iomanip>
 #include <cmath>
 #include <cstring>
+#include <memory>
 
 struct Bar {
     char symbol[32];
-    uint64_t start_time; // HHMM00000 (ms)
+    int64_t start_time;  // 周期起点 (epoch ns)
     double open;
     double high;
     double low;
@@ -22,37 +24,35 @@ struct Bar {
     int last_tick_vol;
     double last_tick_turnover;
     bool initialized;
+    const TradingDaySessions* sessions; // 所属交易日的交易时段 (交易日变化时重新查询)
 };
 
-// 简单的 K 线生成器
+// 简单的 K 线生成器：周期按交易时段对齐 (跨休市连续计时，夜盘跨零点不断开)
 class BarGenerator {
 public:
-    BarGenerator(int interval_min) : interval_ms_(interval_min * 60 * 1000) {}
+    BarGenerator(int interval_min) : interval_ns_(interval_min * 60 * NS_PER_SEC) {}
 
     void process_tick(const TickRecord& tick) {
-        std::string symbol = tick.symbol;
-        Bar& bar = context_[symbol];
-
-        // 提取时间 (HHMMSSmmm -> ms from 00:00:00)
-        uint64_t t = tick.update_time;
-        int hh = t / 10000000;
-        int mm = (t / 100000) % 100;
-        int ss = (t / 1000) % 100;
-        int ms = t % 1000;
-        
-        long current_ms = hh * 3600000 + mm * 60000 + ss * 1000 + ms;
-        long bar_start_ms = (current_ms / interval_ms_) * interval_ms_;
+        // 记录携带的 instrument_id 与共享表一致时直接作下标；旧日志 (ID 为 0 或已过期) 按合约名查找
+        uint32_t slot = index_(tick.instrument_id, tick.symbol);
+        if (slot == InstrumentIndex::kOverflow) return;
+        Bar& bar = context_[slot];
+
+        if (!bar.sessions || bar.sessions->trading_day != tick.trading_day) {
+            bar.sessions = &calendar_.sessions(tick.symbol, tick.trading_day);
+        }
+        int64_t bar_start = bar.sessions->bar_start(tick.exchange_time, interval_ns_);
 
         // 初始化
         if (!bar.initialized) {
-            init_bar(bar, tick, bar_start_ms);
+            init_bar(bar, tick, bar_start);
             return; // 第一个 Tick 仅用于初始化状态，不计入成交量（除非是当天的第一个 Tick，这里简化处理）
         }
 
         // 检查新周期
-        if (current_ms >= bar.start_time + interval_ms_) {
+        if (bar_start > bar.start_time) {
             finish_bar(bar);
-            init_bar(bar, tick, bar_start_ms);
+            init_bar(bar, tick, bar_start);
             // 这里新 Bar 的 Volume 需要包含当前 Tick 的增量
             // 但因为 init_bar 会重置 volume=0，我们需要修正
         }
@@ -78,17 +78,17 @@ public:
     }
 
     void finish_all() {
-        for (auto& pair : context_) {
-            if (pair.second.initialized) {
-                finish_bar(pair.second);
+        for (const Bar& bar : context_) {
+            if (bar.initialized) {
+                finish_bar(bar);
             }
         }
     }
 
 private:
-    void init_bar(Bar& bar, const TickRecord& tick, long start_ms) {
+    void init_bar(Bar& bar, const TickRecord& tick, int64_t start_time) {
         strncpy(bar.symbol, tick.symbol, 31);
-        bar.start_time = start_ms;
+        bar.start_time = start_time;
         bar.open = tick.last_price;
         bar.high = tick.last_price;
         bar.low = tick.last_price;
@@ -102,8 +102,8 @@ private:
     }
 
     void finish_bar(const Bar& bar) {
-        // 格式化时间 HH:MM:00
-        long s = bar.start_time / 1000;
+        // 格式化时间 HH:MM:00 (交易所时间)
+        long s = exchange_ms_of_day(bar.start_time) / 1000;
         int hh = s / 3600;
         int mm = (s % 3600) / 60;
         
@@ -120,33 +120,45 @@ private:
                   << std::endl;
     }
 
-    int interval_ms_;
-    std::unordered_map<std::string, Bar> context_;
+    int64_t interval_ns_;
+    TradingCalendar calendar_;
+    InstrumentIndex index_;
+    std::vector<Bar> context_ = std::vector<Bar>(InstrumentIndex::kSlots);
 };
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <dat_file> [interval_min]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <base_path> [interval_min]" << std::endl;
         return 1;
     }
 
-    std::string file_path = argv[1];
+    // 兼容直接传入 .dat 文件名
+    std::string base_path = argv[1];
+    if (base_path.size() > 4 && base_path.compare(base_path.size() - 4, 4, ".dat") == 0) {
+        base_path.resize(base_path.size() - 4);
+    }
     int interval = 1;
     if (argc > 2) interval = std::stoi(argv[2]);
 
-    std::ifstream ifs(file_path, std::ios::binary);
-    if (!ifs) {
-        std::cerr << "Error: Cannot open " << file_path << std::endl;
+    // 通过 MmapReader 读取：只处理游标之前的有效记录，并自动跨越分段
+    std::unique_ptr<MmapReader<TickRecord>> reader;
+    try {
+        reader = std::make_unique<MmapReader<TickRecord>>(base_path);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Cannot open " << base_path << ": " << e.what() << std::endl;
         return 1;
     }
 
     std::cout << "Symbol,Time,Open,High,Low,Close,Volume,Turnover" << std::endl;
 
     BarGenerator bg(interval);
-    TickRecord rec;
-    
-    while (ifs.read(reinterpret_cast<char*>(&rec), sizeof(TickRecord))) {
-        bg.process_tick(rec);
+
+    // 零拷贝：直接在映射区域上处理
+    for (auto batch = reader->peek_batch(); !batch.empty(); batch = reader->peek_batch()) {
+        for (const TickRecord& rec : batch) {
+            bg.process_tick(rec);
+        }
+        reader->commit(batch.size);
     }
     bg.finish_all();
 
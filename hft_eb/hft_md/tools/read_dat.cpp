@@ -1,37 +1,59 @@
 #include "protocol.h"
 #include "mmap_util.h"
+#include "tick_index.h"
 #include <iostream>
 #include <iomanip>
 
+static void print_record(size_t idx, const TickRecord& rec) {
+    std::cout << std::setw(3) << idx << " | "
+              << std::setw(6) << rec.symbol << " | "
+              << rec.trading_day << " | "
+              << std::setw(9) << exchange_hhmmssmmm(rec.exchange_time) << " | "
+              << std::setw(7) << rec.last_price << " | "
+              << std::setw(6) << rec.volume << " | "
+              << std::setw(14) << rec.turnover << " | "
+              << (rec.local_time ? (rec.local_time - rec.exchange_time) / 1000 : 0)
+              << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "用法: " << argv[0] << " <基础文件名(不带后缀)>" << std::endl;
+        std::cerr << "用法: " << argv[0] << " <基础文件名(不带后缀)> [合约 [起始时间 [结束时间]]]" << std::endl;
+        std::cerr << "      指定合约时使用 .idx 索引 (先运行 build_index)，时间格式 HHMMSSmmm (按交易日换算，夜盘可跨零点)" << std::endl;
         return 1;
     }
 
     std::string base_path = argv[1];
-    
+
     try {
         std::cout << "正在映射文件: " << base_path << "..." << std::endl;
         MmapReader<TickRecord> reader(base_path);
-        
-        TickRecord rec;
+
         size_t count = 0;
 
         std::cout << std::fixed << std::setprecision(2);
         std::cout << "----------------------------------------------------------------" << std::endl;
-        std::cout << "IDX | 合约   | 交易日   | 时间         | 价格    | 成交量 | 成交额" << std::endl;
+        std::cout << "IDX | 合约   | 交易日   | 时间      | 价格    | 成交量 | 成交额         | 延迟(us)" << std::endl;
         std::cout << "----------------------------------------------------------------" << std::endl;
 
-        while (reader.read(rec)) {
-            std::cout << std::setw(3) << count++ << " | "
-                      << std::setw(6) << rec.symbol << " | "
-                      << rec.trading_day << " | "
-                      << rec.update_time << " | "
-                      << std::setw(7) << rec.last_price << " | "
-                      << std::setw(6) << rec.volume << " | "
-                      << rec.turnover 
-                      << std::endl;
+        if (argc > 2) {
+            // 按合约 + 时间区间查询：二分定位后只访问命中的 k 条记录
+            TickIndex index(base_path);
+            uint32_t trading_day = index.record_count() > 0 ? reader.at(0).trading_day : 0;
+            int64_t from = argc > 3 ? exchange_time_ns(trading_day, std::stoull(argv[3])) : INT64_MIN;
+            int64_t to = argc > 4 ? exchange_time_ns(trading_day, std::stoull(argv[4])) : INT64_MAX;
+            for (uint64_t n : index.symbol_range(reader, argv[2], from, to)) {
+                print_record(n, reader.at(n));
+                count++;
+            }
+        } else {
+            // 零拷贝：直接在映射区域上逐段打印
+            for (auto batch = reader.peek_batch(); !batch.empty(); batch = reader.peek_batch()) {
+                for (const TickRecord& rec : batch) {
+                    print_record(count++, rec);
+                }
+                reader.commit(batch.size);
+            }
         }
 
         std::cout << "----------------------------------------------------------------" << std::endl;
@@ -3,11 +3,14 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <atomic>
 #include "framework.h"
 
 // 前向声明，隐藏实现细节
 class EventBusImpl;
+class ThreadModel;
 struct PluginHandle;
+struct PluginSpec;
 
 class HftEngine {
 public:
@@ -26,14 +29,32 @@ public:
     void start();
 
     // 运行主循环（阻塞，直到达到指定持续时间）
+    // 若配置了名为 "main" 的线程，调用线程会在此期间执行其上的轮询函数
     void run(int duration_sec);
 
     // 停止所有插件并清理资源
     void stop();
 
+    // 运行期卸载模块：先 stop()，再等总线上的在途回调结束，最后析构并 dlclose
+    // 挂在引擎线程上的模块不支持卸载
+    bool detachModule(const std::string& name);
+
+    // 重新读取配置文件中的插件列表 (策略热替换)：
+    // 新增的模块挂载并启动，删除/停用的卸载，配置变化的先卸载再挂载
+    bool reload();
+
+    // 请求在 run() 期间执行 reload()，只设置原子标志，可在信号处理函数中调用
+    void requestReload();
+
 private:
+    bool loadPlugin(const PluginSpec& spec);
+    void applyDispatchOrder();
+
     // PImpl idiom to hide implementation details
     std::unique_ptr<EventBusImpl> bus_;
+    std::unique_ptr<ThreadModel> threads_;
     std::vector<std::shared_ptr<PluginHandle>> plugins_;
     bool is_running_;
+    std::string config_path_;
+    std::atomic<bool> reload_requested_{false};
 };
@@ -6,6 +6,8 @@
 #include <functional>
 #include <iostream>
 #include <array>
+#include <atomic>
+#include <type_traits>
 #include "../core/include/protocol.h" // 引入 TickRecord 定义
 
 // ==========================================
@@ -21,9 +23,19 @@ enum EventType {
     EVENT_RTN_TRADE,       // 成交回报 (交易所成交)
     EVENT_POS_UPDATE,      // 持仓更新
     EVENT_LOG,             // 日志
+    EVENT_BOOK_DELTA,      // 盘口增量 (book 模块)；新事件只追加在末尾
     MAX_EVENTS
 };
 
+// 事件名 (用于配置解析与监控输出)
+inline const char* event_name(EventType type) {
+    static const char* const names[MAX_EVENTS] = {
+        "EVENT_MARKET_DATA", "EVENT_ORDER_REQ", "EVENT_ORDER_SEND", "EVENT_RTN_ORDER",
+        "EVENT_RTN_TRADE", "EVENT_POS_UPDATE", "EVENT_LOG", "EVENT_BOOK_DELTA"
+    };
+    return (type >= 0 && type < MAX_EVENTS) ? names[type] : "EVENT_UNKNOWN";
+}
+
 // 事件载荷 (Payload)
 // 全系统直接使用 core/protocol.h 中的 TickRecord 作为标准行情结构
 // 彻底废弃 MarketData
@@ -31,6 +43,7 @@ enum EventType {
 
 struct OrderReq {
     char symbol[32];
+    uint32_t instrument_id; // 共享合约表中的 ID，0 表示未登记 (同 TickRecord)
     char direction;   // 'B'uy or 'S'ell
     char offset_flag; // 'O'pen, 'C'lose, 'T'oday (上期所平今)
     double price;
@@ -41,6 +54,7 @@ struct OrderReq {
 struct OrderRtn {
     char order_ref[13];
     char symbol[32];
+    uint32_t instrument_id;
     char direction;      // 'B'/'S'
     char offset_flag;    // 'O'/'C'/'T'
     double limit_price;
@@ -53,6 +67,7 @@ struct OrderRtn {
 // 成交回报
 struct TradeRtn {
     char symbol[32];
+    uint32_t instrument_id;
     char direction;      // 'B'/'S'
     char offset_flag;    // 'O'/'C'/'T'
     double price;
@@ -64,6 +79,7 @@ struct TradeRtn {
 // 持仓明细
 struct PositionDetail {
     char symbol[32];
+    uint32_t instrument_id;
     
     // 多头
     int long_td;
@@ -78,20 +94,296 @@ struct PositionDetail {
     double net_pnl;
 };
 
+// 盘口增量：book 模块按合约比较相邻两笔五档快照，每笔行情至多发布一次，策略不必各自保存上一笔再做差
+// 档位按价格对齐：*_level_delta[i] 为当前第 i 档的挂单量减去上一笔同价位的挂单量
+// (上一笔五档中没有该价位时按 0 计，即整档计为新增)；更深档位的价格仍从 TickRecord 读取
+enum BookDeltaFlag : uint16_t {
+    BOOK_SNAPSHOT  = 1 << 0, // 该合约当天第一笔，没有可比较的上一笔，增量按整档计
+    BOOK_BID_UP    = 1 << 1, // 买一价上移
+    BOOK_BID_DOWN  = 1 << 2, // 买一价下移 (含买盘被吃空)
+    BOOK_ASK_UP    = 1 << 3, // 卖一价上移 (含卖盘被吃空)
+    BOOK_ASK_DOWN  = 1 << 4, // 卖一价下移
+};
+
+struct BookDelta {
+    char symbol[32];
+    uint32_t instrument_id;
+    uint16_t flags;              // BookDeltaFlag 的组合
+    uint8_t bid_changed;         // 按位：第 i 档买价或买量有变化
+    uint8_t ask_changed;
+    int64_t exchange_time;       // 同 TickRecord
+    int64_t local_time;
+    double last_price;
+    int volume_delta;            // 本笔成交量 (累计 volume 之差)
+    int bid_queue_delta;         // 上一笔买一价位上的挂单量变化 (该价位已不在盘口时为 -原挂单量，原一档为空时为当前一档挂单量)
+    int ask_queue_delta;
+    int reserved;
+    double turnover_delta;       // 本笔成交额 (累计 turnover 之差)
+    double open_interest_delta;
+    double bid_price;            // 当前一档，无挂单时价格与数量为 0
+    double ask_price;
+    int bid_volume;
+    int ask_volume;
+    int bid_level_delta[5];
+    int ask_level_delta[5];
+};
+
 // ==========================================
 // 2. 事件总线 (Host 提供)
 // ==========================================
+
+// 事件类型 -> 载荷类型 (编译期映射，供类型化接口做静态检查)
+template <EventType E> struct EventPayload;
+template <> struct EventPayload<EVENT_MARKET_DATA> { using type = TickRecord; };
+template <> struct EventPayload<EVENT_ORDER_REQ>   { using type = OrderReq; };
+template <> struct EventPayload<EVENT_ORDER_SEND>  { using type = OrderReq; };
+template <> struct EventPayload<EVENT_RTN_ORDER>   { using type = OrderRtn; };
+template <> struct EventPayload<EVENT_RTN_TRADE>   { using type = TradeRtn; };
+template <> struct EventPayload<EVENT_POS_UPDATE>  { using type = PositionDetail; };
+template <> struct EventPayload<EVENT_BOOK_DELTA>  { using type = BookDelta; };
+
+// 委托：普通函数指针 + 上下文指针
+// 相比 std::function 没有类型擦除的堆对象与二次间接跳转，
+// 由模板生成的 thunk 可以把成员函数体直接内联进来
+struct Delegate {
+    using Fn = void (*)(void* ctx, const void* data);
+    Fn fn = nullptr;
+    void* ctx = nullptr;
+};
+
+// 批量委托：一次投递一段连续的载荷数组
+struct BatchDelegate {
+    using Fn = void (*)(void* ctx, const void* data, size_t count);
+    Fn fn = nullptr;
+    void* ctx = nullptr;
+};
+
+// 轮询函数：由引擎线程反复调用，返回本轮处理的工作量 (0 表示空闲)
+struct Poller {
+    using Fn = int (*)(void* ctx);
+    Fn fn = nullptr;
+    void* ctx = nullptr;
+};
+
+// 池化事件槽位：由总线按事件类型预分配、带引用计数，载荷紧跟在 64 字节的头部之后
+// 订阅者通过 EventRef 持有槽位即可延后处理，不必自己拷贝整个载荷
+struct alignas(64) PooledEvent {
+    std::atomic<uint32_t> refs{0};
+    void (*recycle)(PooledEvent*) = nullptr; // 引用归零时调用：归还到池 (池空时的堆分配则直接释放)
+    void* pool = nullptr;
+
+    const void* data() const { return this + 1; }
+    void* data() { return this + 1; }
+};
+
+// 事件引用 (不区分类型)：持有期间槽位不会被复用，拷贝增加引用计数，析构时释放
+class EventHandle {
+public:
+    EventHandle() = default;
+    explicit EventHandle(const PooledEvent* e) : e_(const_cast<PooledEvent*>(e)) {
+        if (e_) e_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    EventHandle(const EventHandle& other) : EventHandle(other.e_) {}
+    EventHandle(EventHandle&& other) noexcept : e_(other.e_) { other.e_ = nullptr; }
+    EventHandle& operator=(EventHandle other) noexcept {
+        std::swap(e_, other.e_);
+        return *this;
+    }
+    ~EventHandle() { reset(); }
+
+    void reset() {
+        if (e_ && e_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) e_->recycle(e_);
+        e_ = nullptr;
+    }
+
+    explicit operator bool() const { return e_ != nullptr; }
+    const void* data() const { return e_ ? e_->data() : nullptr; }
+
+    template <typename T>
+    const T& as() const { return *static_cast<const T*>(e_->data()); }
+
+protected:
+    PooledEvent* e_ = nullptr;
+};
+
+// 类型化事件引用：ref->last_price
+template <typename T>
+class EventRef : public EventHandle {
+public:
+    using EventHandle::EventHandle;
+
+    const T& operator*() const { return as<T>(); }
+    const T* operator->() const { return &as<T>(); }
+    const T* get() const { return static_cast<const T*>(data()); }
+};
+
+// 回调耗时统计：按 (事件, 订阅模块) 聚合，单位纳秒
+// 异步订阅统计的是发布线程上的入队耗时，即它占用发布方的时间
+struct HandlerLatency {
+    EventType type;
+    std::string module;
+    bool async = false;
+    uint64_t count = 0;
+    double p50_ns = 0;
+    double p99_ns = 0;
+    double p999_ns = 0;
+    double max_ns = 0;
+};
+
+// 合约过滤：订阅时解析为总线内部的合约位图，发布时只回调命中的订阅者
+// 适用于载荷带 symbol 字段的事件 (行情、报单、回报、持仓)；为空表示不过滤
+struct SymbolFilter {
+    std::vector<std::string> symbols;
+
+    bool empty() const { return symbols.empty(); }
+
+    // 从配置字符串解析，例如 "au2606,rb2410"
+    static SymbolFilter parse(const std::string& csv) {
+        SymbolFilter f;
+        size_t pos = 0;
+        while (pos <= csv.size()) {
+            size_t end = csv.find(',', pos);
+            if (end == std::string::npos) end = csv.size();
+            std::string item = csv.substr(pos, end - pos);
+            item.erase(0, item.find_first_not_of(" \t"));
+            item.erase(item.find_last_not_of(" \t") + 1);
+            if (!item.empty()) f.symbols.push_back(item);
+            pos = end + 1;
+        }
+        return f;
+    }
+};
+
+namespace detail {
+template <typename M> struct MethodTraits;
+template <typename C, typename A>
+struct MethodTraits<void (C::*)(const A&)> { using Class = C; using Arg = A; };
+template <typename C, typename A>
+struct MethodTraits<void (C::*)(const A&) const> { using Class = const C; using Arg = A; };
+
+template <auto Method>
+void invoke_method(void* ctx, const void* data) {
+    using Traits = MethodTraits<decltype(Method)>;
+    (static_cast<typename Traits::Class*>(ctx)->*Method)(*static_cast<const typename Traits::Arg*>(data));
+}
+
+// 引用订阅者：回调签名为 void (C::*)(const EventRef<Payload>&)，总线传入的是 PooledEvent*
+template <typename M> struct RefMethodTraits;
+template <typename C, typename A>
+struct RefMethodTraits<void (C::*)(const EventRef<A>&)> { using Class = C; using Arg = A; };
+template <typename C, typename A>
+struct RefMethodTraits<void (C::*)(const EventRef<A>&) const> { using Class = const C; using Arg = A; };
+
+template <auto Method>
+void invoke_ref_method(void* ctx, const void* event) {
+    using Traits = RefMethodTraits<decltype(Method)>;
+    EventRef<typename Traits::Arg> ref(static_cast<const PooledEvent*>(event));
+    (static_cast<typename Traits::Class*>(ctx)->*Method)(ref);
+}
+
+template <auto Method, typename C>
+int invoke_poll(void* ctx) {
+    return (static_cast<C*>(ctx)->*Method)();
+}
+
+template <typename M> struct BatchMethodTraits;
+template <typename C, typename A>
+struct BatchMethodTraits<void (C::*)(const A*, size_t)> { using Class = C; using Arg = A; };
+template <typename C, typename A>
+struct BatchMethodTraits<void (C::*)(const A*, size_t) const> { using Class = const C; using Arg = A; };
+
+template <auto Method>
+void invoke_batch_method(void* ctx, const void* data, size_t count) {
+    using Traits = BatchMethodTraits<decltype(Method)>;
+    (static_cast<typename Traits::Class*>(ctx)->*Method)(static_cast<const typename Traits::Arg*>(data), count);
+}
+} // namespace detail
+
 class EventBus {
 public:
+    // 旧接口：std::function 回调，保留用于兼容，热路径请使用类型化接口
     using Handler = std::function<void(void*)>;
     
     virtual ~EventBus() = default;
 
     virtual void subscribe(EventType type, Handler handler) = 0;
-    virtual void publish(EventType type, void* data) = 0;
+    virtual void subscribe_delegate(EventType type, Delegate delegate, const SymbolFilter& filter) = 0;
+    virtual void publish(EventType type, const void* data) = 0;
+
+    // 批量接口：data 指向 count 个连续载荷
+    // 批量订阅者一次拿到整段 (有过滤时按命中的连续区间分段)，普通订阅者仍逐条回调
+    virtual void subscribe_batch_delegate(EventType type, BatchDelegate delegate, const SymbolFilter& filter) = 0;
+    virtual void publish_batch(EventType type, const void* data, size_t count) = 0;
+
+    // 引用订阅：委托收到的是载荷所在的 PooledEvent*，总线在发布时按需把载荷放进事件池 (每次发布至多一次拷贝)
+    virtual void subscribe_ref_delegate(EventType type, Delegate delegate, const SymbolFilter& filter) = 0;
     
     // 安全退出：清空所有回调
     virtual void clear() = 0;
+
+    // 把轮询函数挂到引擎配置的命名线程上 (配置项 "threads")，只能在 init() 中调用
+    // 返回 false 表示没有该线程，模块应回退为自建线程
+    virtual bool add_poller(const std::string& thread_name, Poller poller) = 0;
+
+    // 各回调的耗时分位数 (顶层配置 "latency_stats": true 时才采集，否则返回空)
+    virtual std::vector<HandlerLatency> latency_stats() const = 0;
+
+    // 该类事件因事件池耗尽而改为堆分配的次数 (池容量见顶层配置 "event_pool")
+    virtual uint64_t pool_overflow(EventType type) const = 0;
+
+    // 类型化轮询注册：bus->add_poller<&MyModule::poll>("hot", this); poll 签名为 int ()
+    template <auto Method, typename C>
+    bool add_poller(const std::string& thread_name, C* obj) {
+        return add_poller(thread_name, Poller{&detail::invoke_poll<Method, C>, obj});
+    }
+
+    // 类型化订阅：bus->subscribe<EVENT_MARKET_DATA, &MyModule::onTick>(this);
+    // 回调签名必须是 void (C::*)(const Payload&)，载荷类型在编译期校验
+    // 可选 filter 只让总线投递指定合约的事件
+    template <EventType E, auto Method, typename C>
+    void subscribe(C* obj, const SymbolFilter& filter = SymbolFilter()) {
+        using Arg = typename detail::MethodTraits<decltype(Method)>::Arg;
+        static_assert(std::is_same<Arg, typename EventPayload<E>::type>::value,
+                      "handler argument type does not match event payload");
+        subscribe_delegate(E, Delegate{&detail::invoke_method<Method>, const_cast<void*>(static_cast<const void*>(obj))},
+                           filter);
+    }
+
+    // 类型化批量订阅：回调签名为 void (C::*)(const Payload* data, size_t count)
+    // 适合 K 线、因子等可以按块向量化处理的模块
+    template <EventType E, auto Method, typename C>
+    void subscribe_batch(C* obj, const SymbolFilter& filter = SymbolFilter()) {
+        using Arg = typename detail::BatchMethodTraits<decltype(Method)>::Arg;
+        static_assert(std::is_same<Arg, typename EventPayload<E>::type>::value,
+                      "batch handler argument type does not match event payload");
+        subscribe_batch_delegate(E, BatchDelegate{&detail::invoke_batch_method<Method>,
+                                                  const_cast<void*>(static_cast<const void*>(obj))},
+                                 filter);
+    }
+
+    // 类型化引用订阅：回调签名为 void (C::*)(const EventRef<Payload>&)
+    // 回调中拷贝 EventRef 即可在回调返回后继续持有载荷 (例如放进自己的队列稍后处理)
+    template <EventType E, auto Method, typename C>
+    void subscribe_ref(C* obj, const SymbolFilter& filter = SymbolFilter()) {
+        using Arg = typename detail::RefMethodTraits<decltype(Method)>::Arg;
+        static_assert(std::is_same<Arg, typename EventPayload<E>::type>::value,
+                      "ref handler argument type does not match event payload");
+        subscribe_ref_delegate(E, Delegate{&detail::invoke_ref_method<Method>,
+                                           const_cast<void*>(static_cast<const void*>(obj))},
+                               filter);
+    }
+
+    // 类型化发布：bus->publish<EVENT_MARKET_DATA>(tick);
+    template <EventType E>
+    void publish(const typename EventPayload<E>::type& data) {
+        publish(E, &data);
+    }
+
+    // 类型化批量发布：bus->publish_batch<EVENT_MARKET_DATA>(ticks, n);
+    template <EventType E>
+    void publish_batch(const typename EventPayload<E>::type* data, size_t count) {
+        publish_batch(E, data, count);
+    }
 };
 
 // ==========================================
@@ -131,10 +423,16 @@ public:
 // ==========================================
 // 5. 匾出符号约定
 // ==========================================
+// 插件 ABI 版本：EventBus / IModule 虚函数表、事件编号或事件载荷布局变化时加 1。
+// 引擎加载时与插件编译时的版本比对，不一致 (或旧插件没有导出版本) 直接拒绝，需用当前头文件重新编译
+#define HFT_PLUGIN_ABI_VERSION 2u
+typedef unsigned (*PluginAbiVersionFunc)();
+
 // 每个 .so 必须实现这个函数来创建模块实例
 typedef IModule* (*CreateModuleFunc)();
 #define EXPORT_MODULE(CLASS_NAME) \
     extern "C" { \
+        unsigned hft_plugin_abi_version() { return HFT_PLUGIN_ABI_VERSION; } \
         IModule* create_module() { return new CLASS_NAME(); } \
     }
 
@@ -142,5 +440,6 @@ typedef IModule* (*CreateModuleFunc)();
 typedef IStrategyNode* (*CreateStrategyFunc)();
 #define EXPORT_STRATEGY(CLASS_NAME) \
     extern "C" { \
+        unsigned hft_plugin_abi_version() { return HFT_PLUGIN_ABI_VERSION; } \
         IStrategyNode* create_strategy() { return new CLASS_NAME(); } \
     }
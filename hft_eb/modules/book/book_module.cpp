@@ -0,0 +1,167 @@
+#include "../../include/framework.h"
+#include "instrument_table.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// 盘口模块：按合约保存上一笔五档快照，每笔行情算出档位、成交与一档队列的增量后发布一次 EVENT_BOOK_DELTA
+// 各合约的状态按 InstrumentIndex 的下标分开存放 (下标分配本身线程安全)，同一合约总在同一分片，
+// 因此可以在插件配置中声明 "shard_safe": true，让行情回调在多个分片线程上并发执行
+class BookModule : public IModule {
+public:
+    void init(EventBus* bus, const ConfigMap& config) override {
+        bus_ = bus;
+
+        // 可选：只维护指定合约的盘口 (例如 "rb2410,hc2410")
+        SymbolFilter filter;
+        if (config.count("symbols")) {
+            filter = SymbolFilter::parse(config.at("symbols"));
+        }
+        // 默认只发布有变化的行情；为 true 时每笔行情都发布 (增量可能全为 0)
+        publish_unchanged_ = config.count("publish_unchanged") && config.at("publish_unchanged") == "true";
+        if (config.count("instrument_registry")) index_.open_registry(config.at("instrument_registry"));
+
+        bus_->subscribe<EVENT_MARKET_DATA, &BookModule::onTick>(this, filter);
+        std::cout << "[Book] Initialized." << std::endl;
+    }
+
+    void stop() override {
+        uint64_t ticks = 0, published = 0, stale = 0;
+        for (const Book& book : books_) {
+            ticks += book.ticks;
+            published += book.published;
+            stale += book.stale;
+        }
+        std::cout << "[Book] ticks: " << ticks << ", deltas: " << published << ", stale dropped: " << stale
+                  << ", index overflow: " << index_.overflow() << std::endl;
+    }
+
+private:
+    // 上一笔快照，无效档位 (CTP 以 DBL_MAX 表示) 记为价格 0、数量 0
+    struct Book {
+        uint32_t trading_day = 0;
+        int volume = 0;
+        int64_t exchange_time = 0;
+        double turnover = 0;
+        double open_interest = 0;
+        double bid_price[5] = {};
+        double ask_price[5] = {};
+        int bid_volume[5] = {};
+        int ask_volume[5] = {};
+        uint64_t ticks = 0;
+        uint64_t published = 0;
+        uint64_t stale = 0;
+    };
+
+    static bool valid_price(double price) { return price > 0 && price < DBL_MAX; }
+
+    // 一侧五档中 price 价位的挂单量，不在其中时为 0
+    static int volume_at(const double* prices, const int* volumes, double price) {
+        for (int i = 0; i < 5; ++i) {
+            if (prices[i] == price) return volumes[i];
+        }
+        return 0;
+    }
+
+    // 比较一侧五档：填写按价位对齐的档位增量与变化位图，返回上一笔一档价位上的队列变化
+    static int diff_side(const double* prev_price, const int* prev_volume, const double* price, const int* volume,
+                         int* level_delta, uint8_t& changed) {
+        changed = 0;
+        for (int i = 0; i < 5; ++i) {
+            level_delta[i] = price[i] > 0 ? volume[i] - volume_at(prev_price, prev_volume, price[i]) : 0;
+            if (price[i] != prev_price[i] || volume[i] != prev_volume[i]) changed |= 1 << i;
+        }
+        if (prev_price[0] == 0) return volume[0];
+        return volume_at(price, volume, prev_price[0]) - prev_volume[0];
+    }
+
+    void onTick(const TickRecord& md) {
+        uint32_t slot = index_(md.instrument_id, md.symbol);
+        if (slot == InstrumentIndex::kOverflow) return;
+        Book& book = books_[slot];
+        const bool snapshot = book.ticks == 0 || md.trading_day != book.trading_day;
+        // 多个前置的行情可能乱序到达：累计成交量变小，或成交量相同而时间更早的行情直接丢弃
+        // (只按时间判断时，一笔时间戳错误的行情会让该合约之后的行情全部被丢弃)
+        if (!snapshot && (md.volume < book.volume || (md.volume == book.volume && md.exchange_time < book.exchange_time))) {
+            book.stale++;
+            return;
+        }
+        book.ticks++;
+
+        double bid_price[5], ask_price[5];
+        int bid_volume[5], ask_volume[5];
+        for (int i = 0; i < 5; ++i) {
+            bool bid_ok = valid_price(md.bid_price[i]) && md.bid_volume[i] > 0;
+            bool ask_ok = valid_price(md.ask_price[i]) && md.ask_volume[i] > 0;
+            bid_price[i] = bid_ok ? md.bid_price[i] : 0;
+            bid_volume[i] = bid_ok ? md.bid_volume[i] : 0;
+            ask_price[i] = ask_ok ? md.ask_price[i] : 0;
+            ask_volume[i] = ask_ok ? md.ask_volume[i] : 0;
+        }
+        if (snapshot) {
+            // 新交易日累计字段重新计数，与空盘口比较即得整档增量
+            Book fresh;
+            fresh.ticks = book.ticks;
+            fresh.published = book.published;
+            fresh.stale = book.stale;
+            fresh.volume = md.volume;
+            fresh.turnover = md.turnover;
+            fresh.open_interest = md.open_interest;
+            book = fresh;
+        }
+
+        BookDelta d;
+        memset(&d, 0, sizeof(d));
+        memcpy(d.symbol, md.symbol, sizeof(d.symbol));
+        d.instrument_id = md.instrument_id;
+        d.exchange_time = md.exchange_time;
+        d.local_time = md.local_time;
+        d.last_price = md.last_price;
+        d.volume_delta = md.volume - book.volume;
+        d.turnover_delta = std::max(md.turnover - book.turnover, 0.0);
+        d.open_interest_delta = md.open_interest - book.open_interest;
+        d.bid_price = bid_price[0];
+        d.ask_price = ask_price[0];
+        d.bid_volume = bid_volume[0];
+        d.ask_volume = ask_volume[0];
+        d.bid_queue_delta = diff_side(book.bid_price, book.bid_volume, bid_price, bid_volume, d.bid_level_delta, d.bid_changed);
+        d.ask_queue_delta = diff_side(book.ask_price, book.ask_volume, ask_price, ask_volume, d.ask_level_delta, d.ask_changed);
+
+        // 一档为空视为买价 0 / 卖价无穷大，吃空买盘即买一下移、吃空卖盘即卖一上移
+        if (snapshot) {
+            d.flags |= BOOK_SNAPSHOT;
+        } else if (bid_price[0] != book.bid_price[0]) {
+            d.flags |= bid_price[0] > book.bid_price[0] ? BOOK_BID_UP : BOOK_BID_DOWN;
+        }
+        if (!snapshot && ask_price[0] != book.ask_price[0]) {
+            bool up = ask_price[0] == 0 || (book.ask_price[0] != 0 && ask_price[0] > book.ask_price[0]);
+            d.flags |= up ? BOOK_ASK_UP : BOOK_ASK_DOWN;
+        }
+
+        book.trading_day = md.trading_day;
+        book.exchange_time = md.exchange_time;
+        book.volume = md.volume;
+        book.turnover = md.turnover;
+        book.open_interest = md.open_interest;
+        memcpy(book.bid_price, bid_price, sizeof(bid_price));
+        memcpy(book.ask_price, ask_price, sizeof(ask_price));
+        memcpy(book.bid_volume, bid_volume, sizeof(bid_volume));
+        memcpy(book.ask_volume, ask_volume, sizeof(ask_volume));
+
+        if (!publish_unchanged_ && d.flags == 0 && d.bid_changed == 0 && d.ask_changed == 0 && d.volume_delta == 0 &&
+            d.open_interest_delta == 0) {
+            return;
+        }
+        book.published++;
+        bus_->publish<EVENT_BOOK_DELTA>(d);
+    }
+
+    EventBus* bus_ = nullptr;
+    bool publish_unchanged_ = false;
+    InstrumentIndex index_;
+    std::vector<Book> books_ = std::vector<Book>(InstrumentIndex::kSlots);
+};
+
+EXPORT_MODULE(BookModule)
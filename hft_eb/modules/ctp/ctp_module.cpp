@@ -1,4 +1,6 @@
 #include "../../include/framework.h"
+#include "instrument_table.h"
+#include "trading_calendar.h"
 #include <thread>
 #include <chrono>
 #include <atomic>
@@ -9,14 +11,23 @@ public:
     void init(EventBus* bus, const ConfigMap& config) override {
         bus_ = bus;
         symbol_ = config.at("symbol");
+        // 录制器的共享合约表存在时，模拟行情也携带该合约的 ID
+        try {
+            auto registry = open_instrument_table(config.count("instrument_registry") ? config.at("instrument_registry")
+                                                                                      : INSTRUMENT_TABLE_DEFAULT_PATH);
+            if (registry) instrument_id_ = registry->find(symbol_.c_str());
+        } catch (const std::exception& e) {
+            std::cerr << "[CTP] 无法打开合约表: " << e.what() << std::endl;
+        }
         std::cout << "[CTP] Initialized for " << symbol_ << std::endl;
         
         // 订阅报单请求，模拟发单
-        bus_->subscribe(EVENT_ORDER_REQ, [this](void* d) {
-            auto req = static_cast<OrderReq*>(d);
-            std::cout << "[CTP] -> Sending Order to Exchange: " 
-                      << req->direction << " @ " << req->price << std::endl;
-        });
+        bus_->subscribe<EVENT_ORDER_REQ, &CtpModule::onOrderReq>(this);
+    }
+
+    void onOrderReq(const OrderReq& req) {
+        std::cout << "[CTP] -> Sending Order to Exchange: " 
+                  << req.direction << " @ " << req.price << std::endl;
     }
 
     void start() override {
@@ -31,11 +42,14 @@ public:
                 TickRecord md;
                 memset(&md, 0, sizeof(TickRecord));
                 strncpy(md.symbol, symbol_.c_str(), 31);
+                md.instrument_id = instrument_id_;
+                md.exchange_time = md.local_time = realtime_ns();
+                md.trading_day = trading_day_of(md.exchange_time);
                 md.last_price = price;
                 md.volume = 1;
 
                 std::cout << "[CTP] <- OnRtnDepthMarketData: " << price << std::endl;
-                bus_->publish(EVENT_MARKET_DATA, &md);
+                bus_->publish<EVENT_MARKET_DATA>(md);
 
                 std::this_thread::sleep_for(std::chrono::milliseconds(500));
             }
@@ -50,6 +64,7 @@ public:
 private:
     EventBus* bus_;
     std::string symbol_;
+    uint32_t instrument_id_ = INSTRUMENT_NONE;
     std::thread worker_;
     std::atomic<bool> running_;
 };
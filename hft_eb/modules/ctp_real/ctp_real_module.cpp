@@ -1,11 +1,13 @@
 #include "../../include/framework.h"
 #include "ThostFtdcTraderApi.h"
+#include "instrument_table.h"
 #include <thread>
 #include <chrono>
 #include <atomic>
 #include <cstring>
 #include <iostream>
 #include <mutex>
+#include <memory>
 
 class CtpRealModule : public IModule {
 public:
@@ -17,7 +19,12 @@ public:
     void stop() override;
 
     // Internal helper to send order
-    void send_order(const OrderReq* req);
+    void send_order(const OrderReq& req);
+
+    // 回报中的合约名 -> 共享合约表中的 ID (没有共享表或未登记时为 0)
+    uint32_t instrument_id(const char* symbol) const {
+        return instruments_ ? instruments_->find(symbol) : INSTRUMENT_NONE;
+    }
 
 private:
     // Config
@@ -29,7 +36,8 @@ private:
     std::string auth_code_;
 
     EventBus* bus_ = nullptr;
-    
+    std::unique_ptr<InstrumentTable> instruments_; // 只读
+
     // CTP Trader API
     CThostFtdcTraderApi* td_api_ = nullptr;
 
@@ -79,12 +87,19 @@ void CtpRealModule::init(EventBus* bus, const ConfigMap& config) {
     if (config.count("app_id")) app_id_ = config.at("app_id");
     if (config.count("auth_code")) auth_code_ = config.at("auth_code");
 
+    // 录制器创建的共享合约表，用于给回报补上 instrument_id
+    std::string registry = config.count("instrument_registry") ? config.at("instrument_registry")
+                                                               : INSTRUMENT_TABLE_DEFAULT_PATH;
+    try {
+        instruments_ = open_instrument_table(registry);
+    } catch (const std::exception& e) {
+        std::cerr << "[CTP-Trade] 无法打开合约表 " << registry << ": " << e.what() << std::endl;
+    }
+
     std::cout << "[CTP-Trade] Initialized for Broker=" << broker_id_ << ", User=" << user_id_ << std::endl;
 
     // Subscribe to Authorized Order Commands (from Risk/Manual)
-    bus_->subscribe(EVENT_ORDER_SEND, [this](void* data) {
-        this->send_order(static_cast<OrderReq*>(data));
-    });
+    bus_->subscribe<EVENT_ORDER_SEND, &CtpRealModule::send_order>(this);
 }
 
 void CtpRealModule::start() {
@@ -110,7 +125,7 @@ void CtpRealModule::stop() {
     logged_in_ = false;
 }
 
-void CtpRealModule::send_order(const OrderReq* req) {
+void CtpRealModule::send_order(const OrderReq& req) {
     if (!td_api_ || !logged_in_.load()) {
         std::cerr << "[CTP-Trade] Error: Trader API not ready or not logged in." << std::endl;
         return;
@@ -119,22 +134,22 @@ void CtpRealModule::send_order(const OrderReq* req) {
     CThostFtdcInputOrderField order = {0};
     strncpy(order.BrokerID, broker_id_.c_str(), sizeof(order.BrokerID) - 1);
     strncpy(order.InvestorID, user_id_.c_str(), sizeof(order.InvestorID) - 1);
-    strncpy(order.InstrumentID, req->symbol, sizeof(order.InstrumentID) - 1);
+    strncpy(order.InstrumentID, req.symbol, sizeof(order.InstrumentID) - 1);
     
     snprintf(order.OrderRef, sizeof(order.OrderRef), "%d", req_id_++);
     
     order.OrderPriceType = THOST_FTDC_OPT_LimitPrice;
-    order.Direction = (req->direction == 'B') ? THOST_FTDC_D_Buy : THOST_FTDC_D_Sell;
+    order.Direction = (req.direction == 'B') ? THOST_FTDC_D_Buy : THOST_FTDC_D_Sell;
     
     // Mapping OffsetFlag
-    if (req->offset_flag == 'O') order.CombOffsetFlag[0] = THOST_FTDC_OF_Open;
-    else if (req->offset_flag == 'T') order.CombOffsetFlag[0] = THOST_FTDC_OF_CloseToday;
+    if (req.offset_flag == 'O') order.CombOffsetFlag[0] = THOST_FTDC_OF_Open;
+    else if (req.offset_flag == 'T') order.CombOffsetFlag[0] = THOST_FTDC_OF_CloseToday;
     else order.CombOffsetFlag[0] = THOST_FTDC_OF_Close;
 
     order.CombHedgeFlag[0] = THOST_FTDC_HF_Speculation;
     
-    order.LimitPrice = req->price;
-    order.VolumeTotalOriginal = req->volume;
+    order.LimitPrice = req.price;
+    order.VolumeTotalOriginal = req.volume;
     
     order.TimeCondition = THOST_FTDC_TC_GFD;
     order.VolumeCondition = THOST_FTDC_VC_AV;
@@ -147,8 +162,8 @@ void CtpRealModule::send_order(const OrderReq* req) {
     if (ret != 0) {
         std::cerr << "[CTP-Trade] Order Insert Failed: " << ret << std::endl;
     } else {
-        std::cout << "[CTP-Trade] Order Sent: " << req->symbol << " " << req->direction 
-                  << " @ " << req->price << " (Ref=" << order.OrderRef << ")" << std::endl;
+        std::cout << "[CTP-Trade] Order Sent: " << req.symbol << " " << req.direction 
+                  << " @ " << req.price << " (Ref=" << order.OrderRef << ")" << std::endl;
     }
 }
 
@@ -218,6 +233,7 @@ void CtpRealModule::TraderSpi::OnRtnOrder(CThostFtdcOrderField *pOrder) {
     OrderRtn rtn;
     strncpy(rtn.order_ref, pOrder->OrderRef, 12);
     strncpy(rtn.symbol, pOrder->InstrumentID, 31);
+    rtn.instrument_id = parent_->instrument_id(rtn.symbol);
     rtn.direction = (pOrder->Direction == THOST_FTDC_D_Buy) ? 'B' : 'S';
     
     if (pOrder->CombOffsetFlag[0] == THOST_FTDC_OF_Open) rtn.offset_flag = 'O';
@@ -237,7 +253,7 @@ void CtpRealModule::TraderSpi::OnRtnOrder(CThostFtdcOrderField *pOrder) {
 
     strncpy(rtn.status_msg, pOrder->StatusMsg, 80);
 
-    parent_->bus_->publish(EVENT_RTN_ORDER, &rtn);
+    parent_->bus_->publish<EVENT_RTN_ORDER>(rtn);
 }
 
 void CtpRealModule::TraderSpi::OnRtnTrade(CThostFtdcTradeField *pTrade) {
@@ -247,6 +263,7 @@ void CtpRealModule::TraderSpi::OnRtnTrade(CThostFtdcTradeField *pTrade) {
 
     TradeRtn rtn;
     strncpy(rtn.symbol, pTrade->InstrumentID, 31);
+    rtn.instrument_id = parent_->instrument_id(rtn.symbol);
     rtn.direction = (pTrade->Direction == THOST_FTDC_D_Buy) ? 'B' : 'S';
     
     if (pTrade->OffsetFlag == THOST_FTDC_OF_Open) rtn.offset_flag = 'O';
@@ -258,7 +275,7 @@ void CtpRealModule::TraderSpi::OnRtnTrade(CThostFtdcTradeField *pTrade) {
     strncpy(rtn.trade_id, pTrade->TradeID, 20);
     strncpy(rtn.order_ref, pTrade->OrderRef, 12);
 
-    parent_->bus_->publish(EVENT_RTN_TRADE, &rtn);
+    parent_->bus_->publish<EVENT_RTN_TRADE>(rtn);
 }
 
 void CtpRealModule::TraderSpi::OnErrRtnOrderInsert(CThostFtdcInputOrderField *pInputOrder, CThostFtdcRspInfoField *pRspInfo) {
@@ -12,13 +12,10 @@
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
 
+// 只持有事件池槽位的引用，不拷贝载荷；出队序列化后释放
 struct MonitorEvent {
     EventType type;
-    union Payload {
-        TickRecord md;
-        OrderRtn rtn;
-        PositionDetail pos;
-    } data;
+    EventHandle event;
 };
 
 class MonitorModule : public IModule {
@@ -32,34 +29,53 @@ public:
             pub_addr_ = "tcp://*:5555";
         }
 
+        // 总线回调耗时的推送周期 (需引擎开启 latency_stats)，0 表示不推送
+        if (config.count("latency_interval_ms")) {
+            latency_interval_ = std::chrono::milliseconds(std::stol(config.at("latency_interval_ms")));
+        }
+
         std::cout << "[Monitor] 初始化完成。发布地址: " << pub_addr_ << std::endl;
 
-        // 订阅事件并压入队列（生产者：极速 memcpy）
-        bus_->subscribe(EVENT_MARKET_DATA, [this](void* d) {
-            MonitorEvent evt;
-            evt.type = EVENT_MARKET_DATA;
-            std::memcpy(&evt.data.md, d, sizeof(TickRecord));
-            queue_.push(evt);
-        });
-
-        bus_->subscribe(EVENT_RTN_ORDER, [this](void* d) {
-            MonitorEvent evt;
-            evt.type = EVENT_RTN_ORDER;
-            std::memcpy(&evt.data.rtn, d, sizeof(OrderRtn));
-            queue_.push(evt); 
-        });
-
-        bus_->subscribe(EVENT_POS_UPDATE, [this](void* d) {
-            MonitorEvent evt;
-            evt.type = EVENT_POS_UPDATE;
-            std::memcpy(&evt.data.pos, d, sizeof(PositionDetail));
-            queue_.push(evt);
-        });
+        // 可选：行情只推送指定合约
+        SymbolFilter md_filter;
+        if (config.count("symbols")) {
+            md_filter = SymbolFilter::parse(config.at("symbols"));
+        }
+
+        // 引用订阅：事件入队只增加一次引用计数
+        bus_->subscribe_ref<EVENT_MARKET_DATA, &MonitorModule::onTick>(this, md_filter);
+        bus_->subscribe_ref<EVENT_RTN_ORDER, &MonitorModule::onOrderRtn>(this);
+        bus_->subscribe_ref<EVENT_POS_UPDATE, &MonitorModule::onPosUpdate>(this);
+
+        // 可选：挂到引擎线程上轮询，而不是自建 I/O 线程
+        if (config.count("thread")) {
+            polled_ = bus_->add_poller<&MonitorModule::poll>(config.at("thread"), this);
+            if (!polled_) {
+                std::cerr << "[Monitor] 引擎线程 " << config.at("thread") << " 不存在，使用自建线程" << std::endl;
+            }
+        }
+    }
+
+    void onTick(const EventRef<TickRecord>& md) {
+        queue_.push(MonitorEvent{EVENT_MARKET_DATA, md});
+    }
+
+    void onOrderRtn(const EventRef<OrderRtn>& rtn) {
+        queue_.push(MonitorEvent{EVENT_RTN_ORDER, rtn});
+    }
+
+    void onPosUpdate(const EventRef<PositionDetail>& pos) {
+        queue_.push(MonitorEvent{EVENT_POS_UPDATE, pos});
     }
 
     void start() override {
         running_ = true;
-        worker_ = std::thread(&MonitorModule::io_loop, this);
+        if (polled_) {
+            // 由引擎线程调用 poll()，这里只建好 socket
+            open_socket();
+        } else {
+            worker_ = std::thread(&MonitorModule::io_loop, this);
+        }
     }
 
     void stop() override {
@@ -67,66 +83,131 @@ public:
         if (worker_.joinable()) {
             worker_.join();
         }
+        if (polled_) {
+            close_socket();
+        }
     }
 
 private:
-    void io_loop() {
-        void* context = zmq_ctx_new();
-        void* publisher = zmq_socket(context, ZMQ_PUB);
-        zmq_bind(publisher, pub_addr_.c_str());
+    void open_socket() {
+        context_ = zmq_ctx_new();
+        publisher_ = zmq_socket(context_, ZMQ_PUB);
+        zmq_bind(publisher_, pub_addr_.c_str());
+    }
 
-        std::cout << "[Monitor] 后台序列化线程已启动。" << std::endl;
+    void close_socket() {
+        if (publisher_) zmq_close(publisher_);
+        if (context_) zmq_ctx_destroy(context_);
+        publisher_ = nullptr;
+        context_ = nullptr;
+    }
 
+    // 每次最多处理 64 条，避免长时间占住共享的引擎线程
+    int poll() {
         MonitorEvent evt;
+        int n = 0;
+        while (n < 64 && queue_.pop(evt)) {
+            send_event(evt);
+            evt.event.reset();
+            n++;
+        }
+        if (latency_interval_.count() > 0) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= next_latency_) {
+                next_latency_ = now + latency_interval_;
+                send_latency();
+            }
+        }
+        return n;
+    }
+
+    void io_loop() {
+        open_socket();
+        std::cout << "[Monitor] 后台序列化线程已启动。" << std::endl;
+
         while (running_) {
-            if (queue_.pop(evt)) {
-                rapidjson::StringBuffer sb;
-                rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-                
-                writer.StartObject();
-                
-                if (evt.type == EVENT_MARKET_DATA) {
-                    writer.Key("type"); writer.String("MARKET_DATA");
-                    writer.Key("data");
-                    writer.StartObject();
-                    writer.Key("symbol"); writer.String(evt.data.md.symbol);
-                    writer.Key("last_price"); writer.Double(evt.data.md.last_price);
-                    writer.Key("volume"); writer.Int(evt.data.md.volume);
-                    writer.EndObject();
-                } 
-                else if (evt.type == EVENT_RTN_ORDER) {
-                    writer.Key("type"); writer.String("ORDER_RTN");
-                    writer.Key("data");
-                    writer.StartObject();
-                    writer.Key("order_ref"); writer.String(evt.data.rtn.order_ref);
-                    writer.Key("symbol"); writer.String(evt.data.rtn.symbol);
-                    writer.Key("status"); writer.String(std::string(1, evt.data.rtn.status).c_str());
-                    writer.Key("msg"); writer.String(evt.data.rtn.status_msg);
-                    writer.EndObject();
-                }
-                else if (evt.type == EVENT_POS_UPDATE) {
-                    writer.Key("type"); writer.String("POS_UPDATE");
-                    writer.Key("data");
-                    writer.StartObject();
-                    writer.Key("symbol"); writer.String(evt.data.pos.symbol);
-                    writer.Key("long_td"); writer.Int(evt.data.pos.long_td);
-                    writer.Key("long_yd"); writer.Int(evt.data.pos.long_yd);
-                    writer.Key("short_td"); writer.Int(evt.data.pos.short_td);
-                    writer.Key("short_yd"); writer.Int(evt.data.pos.short_yd);
-                    writer.EndObject();
-                }
-
-                writer.EndObject();
-
-                // 发送 JSON 字符串
-                zmq_send(publisher, sb.GetString(), sb.GetSize(), 0);
-            } else {
+            if (poll() == 0) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(1));
             }
         }
 
-        zmq_close(publisher);
-        zmq_ctx_destroy(context);
+        close_socket();
+    }
+
+    void send_event(const MonitorEvent& evt) {
+        rapidjson::StringBuffer sb;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+        
+        writer.StartObject();
+        
+        if (evt.type == EVENT_MARKET_DATA) {
+            const TickRecord& md = evt.event.as<TickRecord>();
+            writer.Key("type"); writer.String("MARKET_DATA");
+            writer.Key("data");
+            writer.StartObject();
+            writer.Key("symbol"); writer.String(md.symbol);
+            writer.Key("last_price"); writer.Double(md.last_price);
+            writer.Key("volume"); writer.Int(md.volume);
+            writer.EndObject();
+        } 
+        else if (evt.type == EVENT_RTN_ORDER) {
+            const OrderRtn& rtn = evt.event.as<OrderRtn>();
+            writer.Key("type"); writer.String("ORDER_RTN");
+            writer.Key("data");
+            writer.StartObject();
+            writer.Key("order_ref"); writer.String(rtn.order_ref);
+            writer.Key("symbol"); writer.String(rtn.symbol);
+            writer.Key("status"); writer.String(std::string(1, rtn.status).c_str());
+            writer.Key("msg"); writer.String(rtn.status_msg);
+            writer.EndObject();
+        }
+        else if (evt.type == EVENT_POS_UPDATE) {
+            const PositionDetail& pos = evt.event.as<PositionDetail>();
+            writer.Key("type"); writer.String("POS_UPDATE");
+            writer.Key("data");
+            writer.StartObject();
+            writer.Key("symbol"); writer.String(pos.symbol);
+            writer.Key("long_td"); writer.Int(pos.long_td);
+            writer.Key("long_yd"); writer.Int(pos.long_yd);
+            writer.Key("short_td"); writer.Int(pos.short_td);
+            writer.Key("short_yd"); writer.Int(pos.short_yd);
+            writer.EndObject();
+        }
+
+        writer.EndObject();
+
+        // 发送 JSON 字符串
+        zmq_send(publisher_, sb.GetString(), sb.GetSize(), 0);
+    }
+
+    // {"type":"BUS_LATENCY","data":[{"event":..,"module":..,"count":..,"p50_ns":..,...}]}
+    void send_latency() {
+        auto stats = bus_->latency_stats();
+        if (stats.empty()) return;
+
+        rapidjson::StringBuffer sb;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+
+        writer.StartObject();
+        writer.Key("type"); writer.String("BUS_LATENCY");
+        writer.Key("data");
+        writer.StartArray();
+        for (const auto& l : stats) {
+            writer.StartObject();
+            writer.Key("event"); writer.String(event_name(l.type));
+            writer.Key("module"); writer.String(l.module.c_str());
+            writer.Key("async"); writer.Bool(l.async);
+            writer.Key("count"); writer.Uint64(l.count);
+            writer.Key("p50_ns"); writer.Double(l.p50_ns);
+            writer.Key("p99_ns"); writer.Double(l.p99_ns);
+            writer.Key("p999_ns"); writer.Double(l.p999_ns);
+            writer.Key("max_ns"); writer.Double(l.max_ns);
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+
+        zmq_send(publisher_, sb.GetString(), sb.GetSize(), 0);
     }
 
     EventBus* bus_;
@@ -134,6 +215,11 @@ private:
     RingBuffer<MonitorEvent, 1024> queue_;
     std::thread worker_;
     std::atomic<bool> running_{false};
+    bool polled_ = false;
+    void* context_ = nullptr;
+    void* publisher_ = nullptr;
+    std::chrono::milliseconds latency_interval_{1000};
+    std::chrono::steady_clock::time_point next_latency_;
 };
 
 EXPORT_MODULE(MonitorModule)
@@ -1,75 +1,86 @@
 #include "../../include/framework.h"
+#include "instrument_table.h"
 #include <iostream>
+#include <cstdio>
 #include <cstring>
 #include <mutex>
 #include <iomanip>
+#include <vector>
 
 class PositionModule : public IModule {
 public:
     void init(EventBus* bus, const ConfigMap& config) override {
         bus_ = bus;
+        if (config.count("instrument_registry")) index_.open_registry(config.at("instrument_registry"));
         
         std::cout << "[Position] Initialized." << std::endl;
 
         // 订阅成交回报
-        bus_->subscribe(EVENT_RTN_TRADE, [this](void* d) {
-            this->onTrade(static_cast<TradeRtn*>(d));
-        });
+        bus_->subscribe<EVENT_RTN_TRADE, &PositionModule::onTrade>(this);
         
         // 订阅查询请求（可选，如果策略想主动问）
         // 目前策略主要靠监听 EVENT_POS_UPDATE 被动更新
     }
 
 private:
-    void onTrade(TradeRtn* rtn) {
+    void onTrade(const TradeRtn& rtn) {
         std::lock_guard<std::mutex> lock(mtx_);
 
-        std::string symbol = rtn->symbol;
-        PositionDetail& pos = positions_[symbol];
-        strncpy(pos.symbol, symbol.c_str(), 31);
+        // 按合约 ID 直接定位持仓；成交回报没有 ID 或 ID 已过期时按合约名查找
+        const char* symbol = rtn.symbol;
+        uint32_t slot = index_(rtn.instrument_id, symbol);
+        if (slot == InstrumentIndex::kOverflow) {
+            std::cerr << "[Position] 合约表已满，忽略成交: " << symbol << std::endl;
+            return;
+        }
+        PositionDetail& pos = positions_[slot];
+        if (pos.symbol[0] == '\0') {
+            snprintf(pos.symbol, sizeof(pos.symbol), "%s", symbol);
+            pos.instrument_id = rtn.instrument_id;
+        }
 
         // 简单的逻辑处理，暂未包含复杂的均价计算
         // Buy + Open = 多头增加
-        if (rtn->direction == 'B' && rtn->offset_flag == 'O') {
-            pos.long_td += rtn->volume;
-            std::cout << "[Position] " << symbol << " Long Open: +" << rtn->volume << std::endl;
+        if (rtn.direction == 'B' && rtn.offset_flag == 'O') {
+            pos.long_td += rtn.volume;
+            std::cout << "[Position] " << symbol << " Long Open: +" << rtn.volume << std::endl;
         }
         // Sell + Close = 多头减少
-        else if (rtn->direction == 'S' && (rtn->offset_flag == 'C' || rtn->offset_flag == 'T')) {
+        else if (rtn.direction == 'S' && (rtn.offset_flag == 'C' || rtn.offset_flag == 'T')) {
             // 简单处理：不区分平今平昨，优先扣昨仓（逻辑简化版）
-            if (rtn->offset_flag == 'T') {
-                pos.long_td -= rtn->volume;
+            if (rtn.offset_flag == 'T') {
+                pos.long_td -= rtn.volume;
             } else {
-                if (pos.long_yd >= rtn->volume) {
-                    pos.long_yd -= rtn->volume;
+                if (pos.long_yd >= rtn.volume) {
+                    pos.long_yd -= rtn.volume;
                 } else {
                     // 昨仓不够扣今仓（虽然通常交易所会明确指定，这里做个兜底）
-                    int remain = rtn->volume - pos.long_yd;
+                    int remain = rtn.volume - pos.long_yd;
                     pos.long_yd = 0;
                     pos.long_td -= remain;
                 }
             }
-            std::cout << "[Position] " << symbol << " Long Close: -" << rtn->volume << std::endl;
+            std::cout << "[Position] " << symbol << " Long Close: -" << rtn.volume << std::endl;
         }
         // Sell + Open = 空头增加
-        else if (rtn->direction == 'S' && rtn->offset_flag == 'O') {
-            pos.short_td += rtn->volume;
-            std::cout << "[Position] " << symbol << " Short Open: +" << rtn->volume << std::endl;
+        else if (rtn.direction == 'S' && rtn.offset_flag == 'O') {
+            pos.short_td += rtn.volume;
+            std::cout << "[Position] " << symbol << " Short Open: +" << rtn.volume << std::endl;
         }
         // Buy + Close = 空头减少
-        else if (rtn->direction == 'B' && (rtn->offset_flag == 'C' || rtn->offset_flag == 'T')) {
-            if (rtn->offset_flag == 'T') {
-                pos.short_td -= rtn->volume;
+        else if (rtn.direction == 'B' && (rtn.offset_flag == 'C' || rtn.offset_flag == 'T')) {
+            if (rtn.offset_flag == 'T') {
+                pos.short_td -= rtn.volume;
             } else {
-                 if (pos.short_yd >= rtn->volume) {
-                    pos.short_yd -= rtn->volume;
+                 if (pos.short_yd >= rtn.volume) {
+                    pos.short_yd -= rtn.volume;
                 } else {
-                    int remain = rtn->volume - pos.short_yd;
+                    int remain = rtn.volume - pos.short_yd;
                     pos.short_yd = 0;
                     pos.short_td -= remain;
                 }
             }
-            std::cout << "[Position] " << symbol << " Short Close: -" << rtn->volume << std::endl;
+            std::cout << "[Position] " << symbol << " Short Close: -" << rtn.volume << std::endl;
         }
         
         // 确保不出现负持仓（异常情况）
@@ -79,7 +90,7 @@ private:
         if (pos.short_yd < 0) pos.short_yd = 0;
 
         // 发布持仓更新
-        bus_->publish(EVENT_POS_UPDATE, &pos);
+        bus_->publish<EVENT_POS_UPDATE>(pos);
         
         printPosition(pos);
     }
@@ -92,7 +103,8 @@ private:
     }
 
     EventBus* bus_;
-    std::unordered_map<std::string, PositionDetail> positions_;
+    InstrumentIndex index_;
+    std::vector<PositionDetail> positions_ = std::vector<PositionDetail>(InstrumentIndex::kSlots);
     std::mutex mtx_;
 };
 
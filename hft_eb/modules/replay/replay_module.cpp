@@ -1,13 +1,18 @@
 #include "framework.h"
 #include "protocol.h"
 #include "mmap_util.h"
+#include "tick_archive.h"
+#include "circular_journal.h"
+#include "trading_calendar.h"
 #include <iostream>
 #include <thread>
 #include <atomic>
 #include <cstring>
 #include <chrono>
 #include <filesystem>
-#include <immintrin.h> // 用于 _mm_pause
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -22,59 +27,168 @@ public:
             std::cerr << "[Replay] 配置文件中未指定 data_file!" << std::endl;
         }
 
+        // 每次最多攒多少条已就绪的记录一起发布
+        if (config.count("batch_size")) {
+            batch_size_ = std::max<size_t>(1, std::stoul(config.at("batch_size")));
+        }
+
+        // 自建线程等待新数据的方式：spin (默认，独占一核) / hybrid (先自旋再睡眠) / block (直接睡眠)
+        if (config.count("wait_policy")) {
+            const std::string& p = config.at("wait_policy");
+            if (p == "hybrid") {
+                wait_policy_ = WaitPolicy::Hybrid;
+            } else if (p == "block") {
+                wait_policy_ = WaitPolicy::Block;
+            } else if (p != "spin") {
+                std::cerr << "[Replay] 未知的 wait_policy: " << p << "，使用 spin" << std::endl;
+            }
+        }
+        if (config.count("spin_count")) {
+            spin_count_ = static_cast<uint32_t>(std::stoul(config.at("spin_count")));
+        }
+
+        // 数据分段的内存策略：后台预缺页 / mlock / 大页建议，避免回放线程首次读某页时缺页
+        if (config.count("mmap_populate")) memory_policy_.populate = config.at("mmap_populate") == "true";
+        if (config.count("mmap_lock")) memory_policy_.lock = config.at("mmap_lock") == "true";
+        if (config.count("mmap_huge_pages")) memory_policy_.huge_pages = config.at("mmap_huge_pages") == "true";
+
+        // 以 .arc 结尾时回放收盘后生成的列式归档 (hft_archive)，decode_threads 为后台解码线程数
+        if (file_path_.size() > 4 && file_path_.compare(file_path_.size() - 4, 4, ".arc") == 0) {
+            file_path_.resize(file_path_.size() - 4);
+            archived_ = true;
+        }
+        if (config.count("decode_threads")) {
+            decode_threads_ = static_cast<unsigned>(std::stoul(config.at("decode_threads")));
+        }
+
+        // 录制器的盘中循环日志 (live_journal)：在读者表中登记为 reader_name，从最新位置开始消费
+        if (config.count("circular")) circular_ = config.at("circular") == "true";
+        if (config.count("reader_name")) reader_name_ = config.at("reader_name");
+
+        // 可选：挂到引擎线程上轮询 (例如与策略、风控共用一个独占核)，否则自建线程
+        if (config.count("thread")) {
+            polled_ = bus_->add_poller<&ReplayModule::poll>(config.at("thread"), this);
+            if (!polled_) {
+                std::cerr << "[Replay] 引擎线程 " << config.at("thread") << " 不存在，使用自建线程" << std::endl;
+            }
+        }
+
         std::cout << "[Replay] 模块初始化完成。Mmap 基础路径: " << file_path_ << std::endl;
     }
 
     void start() override {
         running_ = true;
-        thread_ = std::thread(&ReplayModule::run, this);
+        if (!polled_) {
+            thread_ = std::thread(&ReplayModule::run, this);
+        }
     }
 
     void stop() override {
         running_ = false;
         if (thread_.joinable()) thread_.join();
+        reader_.reset();
+        archive_.reset();
+        if (live_) {
+            std::cout << "[Replay] 循环日志被套圈 " << live_->overruns() << " 次，丢失 " << live_->lost() << " 条"
+                      << std::endl;
+            live_.reset();
+        }
     }
 
 private:
+    // 自建线程模式
     void run() {
+        PageFaults start = thread_page_faults();
         while (running_) {
-            try {
-                // 尝试连接到 Mmap 通道
-                MmapReader<TickRecord> reader(file_path_);
-                std::cout << "[Replay] 已连接到 Mmap 管道，开始回放..." << std::endl;
-
-                TickRecord rec;
-                while (running_) {
-                    if (reader.read(rec)) {
-                        publish_tick(rec);
-                    } else {
-                        // 无锁轮询，极低延迟
-                        _mm_pause(); 
-                        
-                        // 可选：如果 CPU 负载过高，可取消下面的注释
-                        // std::this_thread::sleep_for(std::chrono::microseconds(1));
-                    }
-                }
-                return;
-            } catch (const std::exception& e) {
-                // 可能 Writer 尚未创建文件，等待并重试
-                std::cout << "[Replay] 等待数据源 (" << file_path_ << ")... " << e.what() << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (poll() > 0) continue;
+            if (reader_) {
+                // 按 wait_policy 等待写者推进游标；限时返回以便响应 stop()
+                reader_->wait(std::chrono::milliseconds(100));
+            } else if (live_) {
+                live_->wait(std::chrono::milliseconds(100));
+            } else if (archive_) {
+                archive_->wait(std::chrono::milliseconds(100));
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        PageFaults faults = thread_page_faults() - start;
+        std::cout << "[Replay] 回放线程缺页: minor=" << faults.minor << " major=" << faults.major << std::endl;
+    }
+
+    // 一轮轮询：只取当前已就绪的数据，不会为了凑批而等待
+    int poll() {
+        if (!reader_ && !live_ && !archive_ && !connect()) return 0;
+        if (reader_) return drain(*reader_);
+        if (live_) return live_->may_overrun() ? drain_copied(*live_) : drain(*live_);
+        return drain(*archive_);
+    }
+
+    // 直接在映射区域 (归档时为解码缓冲) 上发布，不拷贝到本地缓冲
+    template <typename Reader>
+    int drain(Reader& reader) {
+        RecordSpan<TickRecord> batch = reader.peek_batch(batch_size_);
+        if (batch.empty()) return 0;
+        publish_ticks(batch.data, batch.size);
+        reader.commit(batch.size);
+        return static_cast<int>(batch.size);
+    }
+
+    // 写者可能覆盖未确认记录时 (Overrun 策略)，先拷贝出来，确认未被覆盖后再发布
+    int drain_copied(CircularReader<TickRecord>& reader) {
+        RecordSpan<TickRecord> batch = reader.peek_batch(batch_size_);
+        if (batch.empty()) return 0;
+        copy_.assign(batch.begin(), batch.end());
+        if (!reader.commit(batch.size)) return 0;
+        publish_ticks(copy_.data(), copy_.size());
+        return static_cast<int>(copy_.size());
+    }
+
+    // 尝试连接到 Mmap 通道，失败后 1 秒内不再重试 (不阻塞调用线程)
+    bool connect() {
+        auto now = std::chrono::steady_clock::now();
+        if (now < next_retry_) return false;
+        try {
+            if (archived_) {
+                archive_ = std::make_unique<TickArchiveReader>(file_path_, std::string(), decode_threads_);
+                std::cout << "[Replay] 已打开归档 " << file_path_ << ".arc (" << archive_->record_count()
+                          << " 条)，开始回放..." << std::endl;
+                return true;
+            }
+            // 挂在引擎线程上时由引擎线程负责等待，读者本身只需自旋模式 (只读映射)
+            WaitPolicy policy = polled_ ? WaitPolicy::Spin : wait_policy_;
+            if (circular_) {
+                live_ = std::make_unique<CircularReader<TickRecord>>(file_path_, reader_name_, policy, spin_count_,
+                                                                     memory_policy_);
+                std::cout << "[Replay] 已登记为循环日志读者 " << reader_name_ << " (容量 " << live_->capacity()
+                          << " 条)，从最新位置开始回放..." << std::endl;
+                return true;
             }
+            reader_ = std::make_unique<MmapReader<TickRecord>>(file_path_, policy, spin_count_, memory_policy_);
+            std::cout << "[Replay] 已连接到 Mmap 管道，开始回放..." << std::endl;
+            return true;
+        } catch (const std::exception& e) {
+            // 可能 Writer 尚未创建文件，等待并重试
+            std::cout << "[Replay] 等待数据源 (" << file_path_ << ")... " << e.what() << std::endl;
+            next_retry_ = now + std::chrono::seconds(1);
+            return false;
         }
     }
 
-    void publish_tick(const TickRecord& rec) {
-        // 采样打印：前5条必打，之后每50条打一次
-        if (tick_count_ < 5 || strcmp(rec.symbol, "au2606") == 0) {
-            std::cout << "[Bus] #" << tick_count_ << " | " << rec.symbol
-                      << " | Trading Day: " << rec.trading_day
-                      << " | Update Time: " << rec.update_time
-                      << " | Last: " << rec.last_price << " | Vol: " << rec.volume << std::endl;
+    void publish_ticks(const TickRecord* recs, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            const TickRecord& rec = recs[i];
+            // 采样打印：前5条必打，之后每50条打一次
+            if (tick_count_ < 5 || strcmp(rec.symbol, "au2606") == 0) {
+                std::cout << "[Bus] #" << tick_count_ << " | " << rec.symbol
+                          << " | Trading Day: " << rec.trading_day
+                          << " | Update Time: " << exchange_hhmmssmmm(rec.exchange_time)
+                          << " | Last: " << rec.last_price << " | Vol: " << rec.volume << std::endl;
+            }
+            tick_count_++;
         }
-        tick_count_++;
 
-        bus_->publish(EVENT_MARKET_DATA, const_cast<TickRecord*>(&rec));
+        bus_->publish_batch<EVENT_MARKET_DATA>(recs, n);
     }
 
     EventBus* bus_ = nullptr;
@@ -82,6 +196,20 @@ private:
     std::thread thread_;
     std::atomic<bool> running_{false};
     uint64_t tick_count_ = 0; // 计数器
+    size_t batch_size_ = 64;
+    std::unique_ptr<MmapReader<TickRecord>> reader_;
+    std::unique_ptr<TickArchiveReader> archive_;
+    std::unique_ptr<CircularReader<TickRecord>> live_;
+    std::vector<TickRecord> copy_; // Overrun 策略下的拷贝缓冲
+    bool circular_ = false;
+    std::string reader_name_ = "replay";
+    bool archived_ = false;
+    unsigned decode_threads_ = 0;
+    WaitPolicy wait_policy_ = WaitPolicy::Spin;
+    uint32_t spin_count_ = 4096;
+    MemoryPolicy memory_policy_;
+    std::chrono::steady_clock::time_point next_retry_;
+    bool polled_ = false;
 };
 
 EXPORT_MODULE(ReplayModule)
@@ -17,13 +17,11 @@ public:
         std::cout << "[Risk] Initialized. Max Orders/Sec: " << max_orders_per_sec_ << std::endl;
 
         // 订阅原始报单请求
-        bus_->subscribe(EVENT_ORDER_REQ, [this](void* d) {
-            this->checkRisk(static_cast<OrderReq*>(d));
-        });
+        bus_->subscribe<EVENT_ORDER_REQ, &RiskModule::checkRisk>(this);
     }
 
 private:
-    void checkRisk(OrderReq* req) {
+    void checkRisk(const OrderReq& req) {
         std::lock_guard<std::mutex> lock(mtx_);
         
         auto now = std::chrono::steady_clock::now();
@@ -45,7 +43,7 @@ private:
         order_timestamps_.push_back(now);
         
         // 转发到实际发送事件
-        bus_->publish(EVENT_ORDER_SEND, req);
+        bus_->publish<EVENT_ORDER_SEND>(req);
     }
 
     EventBus* bus_;
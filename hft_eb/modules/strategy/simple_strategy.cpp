@@ -1,6 +1,8 @@
 #include "../../include/framework.h"
+#include "instrument_table.h"
 #include <cstring>
 #include <iostream>
+#include <vector>
 
 class StrategyModule : public IModule {
 public:
@@ -8,70 +10,78 @@ public:
         bus_ = bus;
         buy_thresh_ = std::stod(config.at("buy_thresh"));
         sell_thresh_ = std::stod(config.at("sell_thresh"));
+        if (config.count("instrument_registry")) index_.open_registry(config.at("instrument_registry"));
         
         std::cout << "[Strategy] Range: [" << buy_thresh_ << ", " << sell_thresh_ << "]" << std::endl;
 
+        // 可选：只关注指定合约，由总线过滤 (例如 "rb2410,hc2410")
+        SymbolFilter filter;
+        if (config.count("symbols")) {
+            filter = SymbolFilter::parse(config.at("symbols"));
+        }
+
         // 订阅行情
-        bus_->subscribe(EVENT_MARKET_DATA, [this](void* d) {
-            this->onTick(static_cast<TickRecord*>(d));
-        });
+        bus_->subscribe<EVENT_MARKET_DATA, &StrategyModule::onTick>(this, filter);
 
         // 订阅持仓更新
-        bus_->subscribe(EVENT_POS_UPDATE, [this](void* d) {
-            this->onPosUpdate(static_cast<PositionDetail*>(d));
-        });
+        bus_->subscribe<EVENT_POS_UPDATE, &StrategyModule::onPosUpdate>(this, filter);
     }
 
-    void onTick(TickRecord* md) {
+    void onTick(const TickRecord& md) {
         // 防止数据还未初始化就发单
-        if (md->last_price <= 0.1) return;
+        if (md.last_price <= 0.1) return;
+        uint32_t slot = index_(md.instrument_id, md.symbol);
+        if (slot == InstrumentIndex::kOverflow) return;
+        const PositionDetail& current_pos = positions_[slot];
 
         // --- Buy Logic ---
-        if (md->last_price < buy_thresh_) {
+        if (md.last_price < buy_thresh_) {
             // 1. 如果有空单，先平空
-            int short_pos = current_pos_.short_td + current_pos_.short_yd;
+            int short_pos = current_pos.short_td + current_pos.short_yd;
             if (short_pos > 0) {
-                std::cout << "[Strategy] BUY to CLOSE SHORT. Price: " << md->last_price << std::endl;
-                sendOrder(md->symbol, 'B', 'C', md->last_price); // Close Short
+                std::cout << "[Strategy] BUY to CLOSE SHORT. Price: " << md.last_price << std::endl;
+                sendOrder(md, 'B', 'C', md.last_price); // Close Short
             }
             // 2. 如果没空单，且没多单，才开多 (简化为只能持有一个方向)
-            else if (current_pos_.long_td + current_pos_.long_yd == 0) {
-                std::cout << "[Strategy] BUY to OPEN LONG. Price: " << md->last_price << std::endl;
-                sendOrder(md->symbol, 'B', 'O', md->last_price); // Open Long
+            else if (current_pos.long_td + current_pos.long_yd == 0) {
+                std::cout << "[Strategy] BUY to OPEN LONG. Price: " << md.last_price << std::endl;
+                sendOrder(md, 'B', 'O', md.last_price); // Open Long
             }
         } 
         
         // --- Sell Logic ---
-        else if (md->last_price > sell_thresh_) {
+        else if (md.last_price > sell_thresh_) {
             // 1. 如果有多单，先平多
-            int long_pos = current_pos_.long_td + current_pos_.long_yd;
+            int long_pos = current_pos.long_td + current_pos.long_yd;
             if (long_pos > 0) {
-                std::cout << "[Strategy] SELL to CLOSE LONG. Price: " << md->last_price << std::endl;
-                sendOrder(md->symbol, 'S', 'C', md->last_price); // Close Long
+                std::cout << "[Strategy] SELL to CLOSE LONG. Price: " << md.last_price << std::endl;
+                sendOrder(md, 'S', 'C', md.last_price); // Close Long
             }
             // 2. 如果没多单，且没空单，才开空
-            else if (current_pos_.short_td + current_pos_.short_yd == 0) {
-                std::cout << "[Strategy] SELL to OPEN SHORT. Price: " << md->last_price << std::endl;
-                sendOrder(md->symbol, 'S', 'O', md->last_price); // Open Short
+            else if (current_pos.short_td + current_pos.short_yd == 0) {
+                std::cout << "[Strategy] SELL to OPEN SHORT. Price: " << md.last_price << std::endl;
+                sendOrder(md, 'S', 'O', md.last_price); // Open Short
             }
         }
     }
 
-    void onPosUpdate(PositionDetail* pos) {
-        // 更新本地持仓缓存
-        current_pos_ = *pos;
-        // std::cout << "[Strategy] Pos Updated. Long: " << current_pos_.long_td + current_pos_.long_yd 
-        //           << " Short: " << current_pos_.short_td + current_pos_.short_yd << std::endl;
+    void onPosUpdate(const PositionDetail& pos) {
+        // 更新本地持仓缓存 (按合约 ID 存放)
+        uint32_t slot = index_(pos.instrument_id, pos.symbol);
+        if (slot != InstrumentIndex::kOverflow) positions_[slot] = pos;
+        // std::cout << "[Strategy] Pos Updated. Long: " << pos.long_td + pos.long_yd 
+        //           << " Short: " << pos.short_td + pos.short_yd << std::endl;
     }
 
-    void sendOrder(const char* symbol, char dir, char offset, double price) {
+    void sendOrder(const TickRecord& md, char dir, char offset, double price) {
         OrderReq req;
-        strncpy(req.symbol, symbol, 31);
+        strncpy(req.symbol, md.symbol, 31);
+        req.instrument_id = md.instrument_id;
         req.direction = dir;
         req.offset_flag = offset; // 'O'pen, 'C'lose, 'T'oday
         req.price = price;
         req.volume = 1; // 固定做 1 手
-        bus_->publish(EVENT_ORDER_REQ, &req);
+        bus_->publish<EVENT_ORDER_REQ>(req);
     }
 
 private:
@@ -80,7 +90,8 @@ private:
     double sell_thresh_;
     
     // 本地持仓缓存
-    PositionDetail current_pos_ = {0}; 
+    InstrumentIndex index_;
+    std::vector<PositionDetail> positions_ = std::vector<PositionDetail>(InstrumentIndex::kSlots);
 };
 
 EXPORT_MODULE(StrategyModule)
\ No newline at end of file
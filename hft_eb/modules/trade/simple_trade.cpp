@@ -17,17 +17,15 @@ public:
         std::cout << "[" << id_ << "] Initialized. Subscribing to EVENT_ORDER_REQ..." << std::endl;
 
         // 订阅报单请求事件
-        bus_->subscribe(EVENT_ORDER_REQ, [this](void* d) {
-            this->onOrder(static_cast<OrderReq*>(d));
-        });
+        bus_->subscribe<EVENT_ORDER_REQ, &SimpleTradeModule::onOrder>(this);
     }
 
-    void onOrder(OrderReq* req) {
+    void onOrder(const OrderReq& req) {
         std::cout << "[" << id_ << "] ORDER RECEIVED >> "
-                  << "Symbol: " << req->symbol << " | "
-                  << "Dir: " << req->direction << " | "
-                  << "Price: " << req->price << " | "
-                  << "Vol: " << req->volume 
+                  << "Symbol: " << req.symbol << " | "
+                  << "Dir: " << req.direction << " | "
+                  << "Price: " << req.price << " | "
+                  << "Vol: " << req.volume 
                   << std::endl;
         
         // 模拟报单确认逻辑（此处仅打印）
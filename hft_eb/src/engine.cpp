@@ -1,48 +1,31 @@
 #include "../include/engine.h"
+#include "event_bus.h"
+#include "thread_model.h"
 #include <dlfcn.h>
 #include <iostream>
 #include <fstream>
 #include <thread>
 #include <chrono>
 #include <array>
+#include <algorithm>
 
 #include "rapidjson/document.h"
 #include "rapidjson/istreamwrapper.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
 
 // ==========================================
 // Internal Implementations
 // ==========================================
 
-// --- EventBus 实现 ---
-class EventBusImpl : public EventBus {
-public:
-    void subscribe(EventType type, Handler handler) override {
-        if (type < 0 || type >= MAX_EVENTS) return;
-        handlers_[type].push_back(handler);
-    }
-
-    void publish(EventType type, void* data) override {
-        if (type < 0 || type >= MAX_EVENTS) return;
-        for (auto& h : handlers_[type]) {
-            h(data);
-        }
-    }
-
-    void clear() override {
-        for (auto& vec : handlers_) {
-            vec.clear();
-        }
-    }
-
-private:
-    std::array<std::vector<Handler>, MAX_EVENTS> handlers_;
-};
-
 // --- Plugin Wrapper ---
 struct PluginHandle {
     void* lib_handle;
     std::shared_ptr<IModule> module;
     std::string name;
+    std::string signature; // 插件配置的规范化 JSON，reload 时用于判断是否变化
+    std::vector<std::string> after;  // 分发时排在这些模块之后
+    std::vector<std::string> before; // 分发时排在这些模块之前
 
     PluginHandle() : lib_handle(nullptr), module(nullptr) {}
 
@@ -58,12 +41,242 @@ struct PluginHandle {
     }
 };
 
+// 配置中的一个插件项
+struct PluginSpec {
+    std::string name;
+    std::string library;
+    bool enabled = true;
+    ConfigMap config;
+    DeliveryPolicy policy;
+    std::vector<std::string> after;
+    std::vector<std::string> before;
+    std::string signature;
+};
+
+static bool parseConfigFile(const std::string& path, rapidjson::Document& doc) {
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        std::cerr << "FATAL: Could not open config file!" << std::endl;
+        return false;
+    }
+
+    rapidjson::IStreamWrapper isw(ifs);
+    doc.ParseStream(isw);
+
+    if (doc.HasParseError()) {
+        std::cerr << "FATAL: JSON Parse Error!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 退出时打印各回调的耗时分位数 (仅在开启 latency_stats 时有数据)
+static void printLatencyStats(const EventBus& bus) {
+    auto stats = bus.latency_stats();
+    if (stats.empty()) return;
+    std::cout << ">>> Handler latency (ns): event / module / count / p50 / p99 / p99.9 / max" << std::endl;
+    for (const auto& l : stats) {
+        if (l.count == 0) continue;
+        std::cout << "    " << event_name(l.type) << " / " << l.module << (l.async ? " (async enqueue)" : "")
+                  << " / " << l.count << " / " << static_cast<uint64_t>(l.p50_ns)
+                  << " / " << static_cast<uint64_t>(l.p99_ns) << " / " << static_cast<uint64_t>(l.p999_ns)
+                  << " / " << static_cast<uint64_t>(l.max_ns) << std::endl;
+    }
+}
+
+// 无锁队列 (MpscQueue) 的容量须为 2 的幂：配置值向上取整并告警，超出范围时取边界值，不让构造函数在启动或热加载时抛异常
+static size_t parseQueueCapacity(const std::string& what, const rapidjson::Value& v, size_t fallback) {
+    constexpr uint64_t kMinCapacity = 2;
+    constexpr uint64_t kMaxCapacity = uint64_t(1) << 24;
+    if (!v.IsUint64() || v.GetUint64() == 0) {
+        std::cerr << "   [WARN] " << what << ": invalid queue_capacity, using " << fallback << std::endl;
+        return fallback;
+    }
+    const uint64_t requested = v.GetUint64();
+    uint64_t capacity = kMinCapacity;
+    while (capacity < requested && capacity < kMaxCapacity) capacity <<= 1;
+    if (capacity != requested) {
+        std::cerr << "   [WARN] " << what << ": queue_capacity " << requested << " -> " << capacity
+                  << " (must be a power of 2, at most " << kMaxCapacity << ")" << std::endl;
+    }
+    return capacity;
+}
+
+// 解析插件的投递策略:
+//   "delivery": "async"
+//   "delivery": { "default": "inline", "EVENT_MARKET_DATA": "async", "queue_capacity": 8192 }
+static bool parseDeliveryMode(const std::string& s, DeliveryMode& out) {
+    if (s == "inline") { out = DeliveryMode::Inline; return true; }
+    if (s == "async")  { out = DeliveryMode::Async;  return true; }
+    return false;
+}
+
+static DeliveryPolicy parseDeliveryPolicy(const std::string& plugin, const rapidjson::Value& v) {
+    DeliveryPolicy policy;
+    DeliveryMode mode;
+    if (v.IsString()) {
+        if (parseDeliveryMode(v.GetString(), mode)) policy.default_mode = mode;
+        else std::cerr << "   [WARN] " << plugin << ": unknown delivery mode " << v.GetString() << std::endl;
+        return policy;
+    }
+    if (!v.IsObject()) return policy;
+
+    for (auto& m : v.GetObject()) {
+        std::string key = m.name.GetString();
+        if (key == "queue_capacity") {
+            policy.queue_capacity = parseQueueCapacity(plugin, m.value, policy.queue_capacity);
+            continue;
+        }
+        if (!m.value.IsString() || !parseDeliveryMode(m.value.GetString(), mode)) {
+            std::cerr << "   [WARN] " << plugin << ": invalid delivery entry " << key << std::endl;
+            continue;
+        }
+        EventType type;
+        if (key == "default") policy.default_mode = mode;
+        else if (parse_event_type(key, type)) policy.per_event[type] = static_cast<int>(mode);
+        else std::cerr << "   [WARN] " << plugin << ": unknown event " << key << std::endl;
+    }
+    return policy;
+}
+
+// 解析线程模型:
+//   "threads": [ { "name": "hot", "core": 3, "sched": "fifo", "priority": 80, "idle": "spin" },
+//                { "name": "observer", "idle": "sleep", "sleep_us": 200 } ]
+static bool parseThreadSpec(const rapidjson::Value& v, ThreadSpec& spec) {
+    if (!v.IsObject() || !v.HasMember("name") || !v["name"].IsString()) return false;
+    spec.name = v["name"].GetString();
+    if (v.HasMember("core") && v["core"].IsInt()) spec.core = v["core"].GetInt();
+    if (v.HasMember("sched") && v["sched"].IsString()) {
+        spec.fifo = std::string(v["sched"].GetString()) == "fifo";
+    }
+    if (v.HasMember("priority") && v["priority"].IsInt()) spec.priority = v["priority"].GetInt();
+    if (v.HasMember("sleep_us") && v["sleep_us"].IsInt()) spec.sleep_us = v["sleep_us"].GetInt();
+    if (v.HasMember("idle") && v["idle"].IsString()) {
+        std::string idle = v["idle"].GetString();
+        if (idle == "spin") spec.idle = IdlePolicy::Spin;
+        else if (idle == "yield") spec.idle = IdlePolicy::Yield;
+        else if (idle == "sleep") spec.idle = IdlePolicy::Sleep;
+        else return false;
+    }
+    return true;
+}
+
+// "after": "Risk" 或 "after": ["Risk", "Position"]
+static std::vector<std::string> parseNameList(const rapidjson::Value& v) {
+    std::vector<std::string> names;
+    if (v.IsString()) {
+        names.push_back(v.GetString());
+    } else if (v.IsArray()) {
+        for (const auto& n : v.GetArray()) {
+            if (n.IsString()) names.push_back(n.GetString());
+        }
+    }
+    return names;
+}
+
+// 按模块声明的先后关系计算分发顺序：Kahn 拓扑排序，没有约束的模块之间保持加载顺序
+// 依赖成环时告警，环上的模块按加载顺序追加在末尾
+static std::vector<std::string> resolveDispatchOrder(const std::vector<std::shared_ptr<PluginHandle>>& plugins) {
+    const size_t n = plugins.size();
+    auto index_of = [&plugins](const std::string& name) -> int {
+        for (size_t i = 0; i < plugins.size(); ++i) {
+            if (plugins[i]->name == name) return static_cast<int>(i);
+        }
+        return -1;
+    };
+
+    // edges[i] 中的模块必须排在 i 之后
+    std::vector<std::vector<int>> edges(n);
+    std::vector<int> indegree(n, 0);
+    auto add_edge = [&](int from, int to) {
+        edges[from].push_back(to);
+        indegree[to]++;
+    };
+    for (size_t i = 0; i < n; ++i) {
+        for (const auto& dep : plugins[i]->after) {
+            int j = index_of(dep);
+            if (j < 0) std::cerr << "   [WARN] " << plugins[i]->name << ": after 未知模块 " << dep << std::endl;
+            else add_edge(j, static_cast<int>(i));
+        }
+        for (const auto& dep : plugins[i]->before) {
+            int j = index_of(dep);
+            if (j < 0) std::cerr << "   [WARN] " << plugins[i]->name << ": before 未知模块 " << dep << std::endl;
+            else add_edge(static_cast<int>(i), j);
+        }
+    }
+
+    std::vector<std::string> order;
+    std::vector<bool> done(n, false);
+    for (size_t round = 0; round < n; ++round) {
+        // 每轮取加载顺序最靠前的无前驱模块，保证结果确定
+        int next = -1;
+        for (size_t i = 0; i < n; ++i) {
+            if (!done[i] && indegree[i] == 0) {
+                next = static_cast<int>(i);
+                break;
+            }
+        }
+        if (next < 0) break;
+        done[next] = true;
+        order.push_back(plugins[next]->name);
+        for (int to : edges[next]) indegree[to]--;
+    }
+
+    if (order.size() < n) {
+        std::cerr << "   [WARN] 模块依赖成环，以下模块按加载顺序分发:";
+        for (size_t i = 0; i < n; ++i) {
+            if (!done[i]) {
+                std::cerr << " " << plugins[i]->name;
+                order.push_back(plugins[i]->name);
+            }
+        }
+        std::cerr << std::endl;
+    }
+    return order;
+}
+
+static PluginSpec parsePluginSpec(const rapidjson::Value& p) {
+    PluginSpec spec;
+    spec.name = p["name"].GetString();
+    spec.library = p["library"].GetString();
+    spec.enabled = p.HasMember("enabled") ? p["enabled"].GetBool() : true;
+
+    if (p.HasMember("config") && p["config"].IsObject()) {
+        for (auto& m : p["config"].GetObject()) {
+            if (m.value.IsString()) {
+                spec.config[m.name.GetString()] = m.value.GetString();
+            }
+        }
+    }
+
+    // 投递策略 (inline / async)
+    if (p.HasMember("delivery")) {
+        spec.policy = parseDeliveryPolicy(spec.name, p["delivery"]);
+    }
+    // 开启 md_sharding 时行情回调可在多个分片线程上并发执行 (跨合约状态无竞争的模块才能声明)
+    if (p.HasMember("shard_safe") && p["shard_safe"].IsBool()) {
+        spec.policy.shard_safe = p["shard_safe"].GetBool();
+    }
+
+    // 分发顺序约束
+    if (p.HasMember("after")) spec.after = parseNameList(p["after"]);
+    if (p.HasMember("before")) spec.before = parseNameList(p["before"]);
+
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    p.Accept(writer);
+    spec.signature = sb.GetString();
+    return spec;
+}
+
 // ==========================================
 // HftEngine Implementation
 // ==========================================
 
 HftEngine::HftEngine() : is_running_(false) {
     bus_ = std::make_unique<EventBusImpl>();
+    threads_ = std::make_unique<ThreadModel>();
+    bus_->set_thread_model(threads_.get());
 }
 
 HftEngine::~HftEngine() {
@@ -74,90 +287,227 @@ bool HftEngine::loadConfig(const std::string& config_path) {
     std::cout << ">>> HFT Engine Booting using config: " << config_path << std::endl;
 
     // 1. 读取并解析 JSON
-    std::ifstream ifs(config_path);
-    if (!ifs.is_open()) {
-        std::cerr << "FATAL: Could not open config file!" << std::endl;
+    rapidjson::Document doc;
+    if (!parseConfigFile(config_path, doc)) {
         return false;
     }
-    
-    rapidjson::IStreamWrapper isw(ifs);
-    rapidjson::Document doc;
-    doc.ParseStream(isw);
+    config_path_ = config_path;
 
-    if (doc.HasParseError()) {
-        std::cerr << "FATAL: JSON Parse Error!" << std::endl;
-        return false;
+    // 2. 行情分片 (可选)
+    //   "md_sharding": { "shards": 4, "cores": [2, 3, 4, 5], "queue_capacity": 8192 }
+    if (doc.HasMember("md_sharding") && doc["md_sharding"].IsObject()) {
+        const auto& sh = doc["md_sharding"];
+        ShardingConfig sharding;
+        // 分片数超出范围时不开启分片，行情在发布线程上分发
+        constexpr int kMaxShards = 64;
+        if (sh.HasMember("shards")) {
+            if (sh["shards"].IsInt() && sh["shards"].GetInt() >= 0 && sh["shards"].GetInt() <= kMaxShards) {
+                sharding.shards = sh["shards"].GetInt();
+            } else {
+                std::cerr << "   [WARN] md_sharding: shards must be 0.." << kMaxShards << ", sharding disabled" << std::endl;
+            }
+        }
+        if (sh.HasMember("queue_capacity")) {
+            sharding.queue_capacity = parseQueueCapacity("md_sharding", sh["queue_capacity"], sharding.queue_capacity);
+        }
+        if (sh.HasMember("cores") && sh["cores"].IsArray()) {
+            for (const auto& c : sh["cores"].GetArray()) {
+                if (c.IsInt()) sharding.cores.push_back(c.GetInt());
+            }
+        }
+        bus_->configure_sharding(sharding);
+    }
+
+    // 3. 线程模型 (可选)，须在插件 init() 之前就绪，模块在 init() 中注册轮询函数
+    if (doc.HasMember("threads") && doc["threads"].IsArray()) {
+        std::vector<ThreadSpec> specs;
+        for (const auto& t : doc["threads"].GetArray()) {
+            ThreadSpec spec;
+            if (parseThreadSpec(t, spec)) specs.push_back(spec);
+            else std::cerr << "   [WARN] invalid thread spec ignored" << std::endl;
+        }
+        threads_->configure(specs);
+    }
+
+    // 事件池 (可选)：每类事件预分配的槽位数，供异步队列与引用订阅者持有载荷
+    //   "event_pool": { "capacity": 8192 }
+    if (doc.HasMember("event_pool") && doc["event_pool"].IsObject()) {
+        const auto& ep = doc["event_pool"];
+        if (ep.HasMember("capacity") && ep["capacity"].IsUint() && ep["capacity"].GetUint() > 0) {
+            bus_->configure_pools(ep["capacity"].GetUint());
+        }
+    }
+
+    // 回调耗时统计 (可选)，须在插件订阅之前开启
+    //   "latency_stats": true
+    if (doc.HasMember("latency_stats") && doc["latency_stats"].IsBool() && doc["latency_stats"].GetBool()) {
+        bus_->enable_latency_stats();
     }
 
-    // 2. 遍历插件列表
+    // 4. 遍历插件列表
     if (doc.HasMember("plugins") && doc["plugins"].IsArray()) {
         const auto& plugin_list = doc["plugins"];
         
         for (const auto& p : plugin_list.GetArray()) {
-            std::string name = p["name"].GetString();
-            std::string lib_path = p["library"].GetString();
-            bool enabled = p.HasMember("enabled") ? p["enabled"].GetBool() : true;
-
-            if (!enabled) {
-                std::cout << "[Loader] Skipping disabled module: " << name << std::endl;
+            PluginSpec spec = parsePluginSpec(p);
+            if (!spec.enabled) {
+                std::cout << "[Loader] Skipping disabled module: " << spec.name << std::endl;
                 continue;
             }
+            loadPlugin(spec);
+        }
+    }
 
-            std::cout << "[Loader] Loading Module: " << name << " (" << lib_path << ")..." << std::endl;
+    // 5. 按依赖声明确定各事件的回调顺序
+    applyDispatchOrder();
+    return true;
+}
 
-            // A. 加载动态库
-            void* handle = dlopen(lib_path.c_str(), RTLD_LAZY);
-            if (!handle) {
-                std::cerr << "   [ERROR] dlopen failed: " << dlerror() << std::endl;
-                continue;
-            }
+bool HftEngine::loadPlugin(const PluginSpec& spec) {
+    std::cout << "[Loader] Loading Module: " << spec.name << " (" << spec.library << ")..." << std::endl;
 
-            // B. 获取工厂
-            CreateModuleFunc create_fn = (CreateModuleFunc)dlsym(handle, "create_module");
-            if (!create_fn) {
-                std::cerr << "   [ERROR] create_module symbol not found!" << std::endl;
-                dlclose(handle);
-                continue;
-            }
+    // A. 加载动态库
+    void* handle = dlopen(spec.library.c_str(), RTLD_LAZY);
+    if (!handle) {
+        std::cerr << "   [ERROR] dlopen failed: " << dlerror() << std::endl;
+        return false;
+    }
 
-            // C. 准备配置 map
-            ConfigMap config_map;
-            if (p.HasMember("config") && p["config"].IsObject()) {
-                for (auto& m : p["config"].GetObject()) {
-                    if (m.value.IsString()) {
-                        config_map[m.name.GetString()] = m.value.GetString();
-                    }
-                }
-            }
+    // B. 校验插件 ABI 版本 (旧插件的虚函数表、事件载荷与当前引擎不一致，不能加载)
+    PluginAbiVersionFunc abi_fn = (PluginAbiVersionFunc)dlsym(handle, "hft_plugin_abi_version");
+    unsigned abi = abi_fn ? abi_fn() : 0;
+    if (abi != HFT_PLUGIN_ABI_VERSION) {
+        std::cerr << "   [ERROR] plugin ABI version " << abi << " != " << HFT_PLUGIN_ABI_VERSION
+                  << ", rebuild it against the current headers" << std::endl;
+        dlclose(handle);
+        return false;
+    }
 
-            // D. 实例化并初始化
-            IModule* raw_ptr = create_fn();
-            if (raw_ptr) {
-                raw_ptr->init(bus_.get(), config_map);
+    // C. 获取工厂
+    CreateModuleFunc create_fn = (CreateModuleFunc)dlsym(handle, "create_module");
+    if (!create_fn) {
+        std::cerr << "   [ERROR] create_module symbol not found!" << std::endl;
+        dlclose(handle);
+        return false;
+    }
 
-                auto plugin = std::make_shared<PluginHandle>();
-                plugin->lib_handle = handle;
-                plugin->module = std::shared_ptr<IModule>(raw_ptr);
-                plugin->name = name;
-                plugins_.push_back(plugin);
-            } else {
-                 std::cerr << "   [ERROR] create_module returned null!" << std::endl;
-                 dlclose(handle);
-            }
+    // D. 实例化并初始化
+    IModule* raw_ptr = create_fn();
+    if (!raw_ptr) {
+        std::cerr << "   [ERROR] create_module returned null!" << std::endl;
+        dlclose(handle);
+        return false;
+    }
+
+    bus_->begin_module(spec.name, spec.policy);
+    raw_ptr->init(bus_.get(), spec.config);
+    bus_->end_module();
+
+    auto plugin = std::make_shared<PluginHandle>();
+    plugin->lib_handle = handle;
+    plugin->module = std::shared_ptr<IModule>(raw_ptr);
+    plugin->name = spec.name;
+    plugin->signature = spec.signature;
+    plugin->after = spec.after;
+    plugin->before = spec.before;
+    plugins_.push_back(plugin);
+
+    // E. 运行期挂载的模块立即启动 (引擎线程已启动，轮询注册会失败，模块回退为自建线程)
+    if (is_running_) {
+        plugin->module->start();
+    }
+    return true;
+}
+
+bool HftEngine::detachModule(const std::string& name) {
+    auto it = std::find_if(plugins_.begin(), plugins_.end(),
+                           [&name](const std::shared_ptr<PluginHandle>& p) { return p->name == name; });
+    if (it == plugins_.end()) return false;
+
+    // 引擎线程上的轮询函数没有同步点，不能在运行期摘除
+    if (threads_->has_pollers(name)) {
+        std::cerr << "[Loader] " << name << " 挂在引擎线程上，不支持运行期卸载" << std::endl;
+        return false;
+    }
+
+    std::cout << "[Loader] Detaching Module: " << name << std::endl;
+    if (is_running_) {
+        (*it)->module->stop();
+    }
+    // 总线摘除订阅并等待在途回调结束后，模块才能析构、动态库才能卸载
+    bus_->remove_module(name);
+    plugins_.erase(it);
+    return true;
+}
+
+bool HftEngine::reload() {
+    std::cout << ">>> Reloading plugins from: " << config_path_ << std::endl;
+    rapidjson::Document doc;
+    if (!parseConfigFile(config_path_, doc)) {
+        return false;
+    }
+
+    // 分片、线程等引擎级配置只在启动时生效，这里只处理插件列表
+    std::vector<PluginSpec> specs;
+    if (doc.HasMember("plugins") && doc["plugins"].IsArray()) {
+        for (const auto& p : doc["plugins"].GetArray()) {
+            PluginSpec spec = parsePluginSpec(p);
+            if (spec.enabled) specs.push_back(std::move(spec));
         }
     }
+
+    // 1. 卸载被删除、停用或配置发生变化的模块
+    std::vector<std::string> loaded;
+    for (const auto& p : plugins_) loaded.push_back(p->name);
+    for (const auto& name : loaded) {
+        auto spec = std::find_if(specs.begin(), specs.end(), [&name](const PluginSpec& s) { return s.name == name; });
+        auto plugin = std::find_if(plugins_.begin(), plugins_.end(),
+                                   [&name](const std::shared_ptr<PluginHandle>& p) { return p->name == name; });
+        if (spec == specs.end() || spec->signature != (*plugin)->signature) {
+            detachModule(name);
+        }
+    }
+
+    // 2. 挂载新增 (或刚被卸载的) 模块
+    for (const auto& spec : specs) {
+        bool present = std::any_of(plugins_.begin(), plugins_.end(),
+                                   [&spec](const std::shared_ptr<PluginHandle>& p) { return p->name == spec.name; });
+        if (!present) loadPlugin(spec);
+    }
+
+    // 3. 新挂载的模块按依赖声明插入分发顺序
+    applyDispatchOrder();
     return true;
 }
 
+void HftEngine::applyDispatchOrder() {
+    std::vector<std::string> order = resolveDispatchOrder(plugins_);
+    bus_->set_dispatch_order(order);
+
+    std::cout << "[Loader] Dispatch order:";
+    for (size_t i = 0; i < order.size(); ++i) {
+        std::cout << (i ? " -> " : " ") << order[i];
+    }
+    std::cout << std::endl;
+}
+
+void HftEngine::requestReload() {
+    reload_requested_.store(true, std::memory_order_relaxed);
+}
+
 void HftEngine::start() {
     if (is_running_) return;
 
     std::cout << ">>> All Modules Loaded. Starting..." << std::endl;
+    // 先启动异步消费线程，模块启动后即可能开始发布
+    bus_->start();
     for (auto& p : plugins_) {
         if (p->module) {
             p->module->start();
         }
     }
+    // 模块启动完成后再开始调用其轮询函数
+    threads_->start();
     is_running_ = true;
 }
 
@@ -167,7 +517,23 @@ void HftEngine::run(int duration_sec) {
     }
     
     std::cout << ">>> System Running. (Simulating " << duration_sec << "s run...)" << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(duration_sec));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(duration_sec);
+
+    // 控制线程处理热加载请求 (如 SIGHUP)，直到截止时间
+    std::thread controller([this, deadline] {
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (reload_requested_.exchange(false, std::memory_order_relaxed)) {
+                reload();
+            }
+            // 在自身消费线程上被摘除的异步队列由控制线程 join
+            bus_->reap();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    });
+
+    // 配置了 "main" 线程时，调用线程在此期间执行其上的轮询函数
+    threads_->run_main(deadline);
+    controller.join();
 }
 
 void HftEngine::stop() {
@@ -175,14 +541,26 @@ void HftEngine::stop() {
 
     std::cout << ">>> Shutting down..." << std::endl;
     
-    // 1. 停止模块
+    // 0. 停止引擎线程，之后不再调用任何模块的轮询函数
+    if (threads_) {
+        threads_->stop();
+    }
+
+    // 1. 先停分片与异步消费线程 (排空队列)，队列中的事件在模块停止之前送达；
+    //    之后发布的行情在发布线程上分发，投到异步队列的事件不再送达 (随队列释放)
+    if (bus_) {
+        bus_->stop();
+        printLatencyStats(*bus_);
+    }
+
+    // 2. 停止模块
     for (auto& p : plugins_) {
         if (p && p->module) {
             p->module->stop();
         }
     }
     
-    // 2. [CRITICAL] 清空所有事件回调，防止指向已卸载的内存
+    // 3. [CRITICAL] 清空所有事件回调，防止指向已卸载的内存
     if (bus_) {
         std::cout << ">>> Clearing EventBus..." << std::endl;
         bus_->clear();
@@ -0,0 +1,799 @@
+#include "event_bus.h"
+#include "thread_model.h"
+#include "rcu.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+#include <immintrin.h> // 用于 _mm_pause
+
+namespace {
+// 各事件载荷大小，决定事件池槽位大小与批量发布的步长
+constexpr size_t kPayloadSize[MAX_EVENTS] = {
+    sizeof(EventPayload<EVENT_MARKET_DATA>::type),
+    sizeof(EventPayload<EVENT_ORDER_REQ>::type),
+    sizeof(EventPayload<EVENT_ORDER_SEND>::type),
+    sizeof(EventPayload<EVENT_RTN_ORDER>::type),
+    sizeof(EventPayload<EVENT_RTN_TRADE>::type),
+    sizeof(EventPayload<EVENT_POS_UPDATE>::type),
+    0, // EVENT_LOG: 无固定载荷，不支持异步与引用订阅
+    sizeof(EventPayload<EVENT_BOOK_DELTA>::type),
+};
+
+constexpr size_t kDefaultPoolCapacity = 8192;
+
+// 各事件载荷中 symbol 字段的偏移，用于合约过滤
+constexpr size_t kNoSymbol = static_cast<size_t>(-1);
+constexpr size_t kSymbolOffset[MAX_EVENTS] = {
+    offsetof(TickRecord, symbol),
+    offsetof(OrderReq, symbol),
+    offsetof(OrderReq, symbol),
+    offsetof(OrderRtn, symbol),
+    offsetof(TradeRtn, symbol),
+    offsetof(PositionDetail, symbol),
+    kNoSymbol, // EVENT_LOG
+    offsetof(BookDelta, symbol),
+};
+constexpr size_t kSymbolLen = sizeof(TickRecord::symbol);
+
+// FNV-1a，按 '\0' 或定长截断
+inline uint32_t symbol_hash(const char* symbol, size_t max_len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < max_len && symbol[i]; ++i) {
+        h ^= static_cast<unsigned char>(symbol[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 旧式 std::function 回调的委托 thunk
+void invoke_legacy(void* ctx, const void* data) {
+    (*static_cast<EventBus::Handler*>(ctx))(const_cast<void*>(data));
+}
+
+// 带耗时统计的批量调用 (rdtsc 不串行化，足以分辨 ns 级回调)
+inline void invoke_batch(LatencyHistogram* stats, const BatchDelegate& b, const void* data, size_t count) {
+    if (!stats) {
+        b.fn(b.ctx, data, count);
+        return;
+    }
+    uint64_t t0 = __rdtsc();
+    b.fn(b.ctx, data, count);
+    stats->record(__rdtsc() - t0);
+}
+
+// 批量订阅者收到单条发布时按 count=1 调用
+void invoke_batch_single(void* ctx, const void* data) {
+    const auto* batch = static_cast<const BatchDelegate*>(ctx);
+    batch->fn(batch->ctx, data, 1);
+}
+} // namespace
+
+bool parse_event_type(const std::string& name, EventType& out) {
+    for (int i = 0; i < MAX_EVENTS; ++i) {
+        const char* full = event_name(static_cast<EventType>(i));
+        if (name == full || name == full + 6) { // 跳过 "EVENT_" 前缀
+            out = static_cast<EventType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// ==========================================
+// SymbolTable
+// ==========================================
+
+SymbolTable::SymbolTable() : slots_(new Slot[kSlots]) {}
+
+uint32_t SymbolTable::intern(const char* symbol) {
+    uint32_t h = symbol_hash(symbol, kSymbolLen);
+    for (size_t i = 0; i < kSlots; ++i) {
+        Slot& slot = slots_[(h + i) & (kSlots - 1)];
+        uint32_t state = slot.state.load(std::memory_order_acquire);
+        if (state == 0) {
+            // 抢占空槽
+            if (slot.state.compare_exchange_strong(state, 1, std::memory_order_acquire)) {
+                strncpy(slot.symbol, symbol, kSymbolLen - 1);
+                slot.id = next_id_.fetch_add(1, std::memory_order_relaxed);
+                slot.state.store(2, std::memory_order_release);
+                return slot.id;
+            }
+        }
+        // 其它线程正在写入该槽，等待其完成后再比较
+        while (state == 1) {
+            _mm_pause();
+            state = slot.state.load(std::memory_order_acquire);
+        }
+        if (strncmp(slot.symbol, symbol, kSymbolLen - 1) == 0) return slot.id;
+    }
+    return kInvalidId; // 表满
+}
+
+uint32_t SymbolTable::find(const char* symbol) const {
+    uint32_t h = symbol_hash(symbol, kSymbolLen);
+    for (size_t i = 0; i < kSlots; ++i) {
+        const Slot& slot = slots_[(h + i) & (kSlots - 1)];
+        uint32_t state = slot.state.load(std::memory_order_acquire);
+        if (state == 0) return kInvalidId;
+        if (state == 2 && strncmp(slot.symbol, symbol, kSymbolLen - 1) == 0) return slot.id;
+    }
+    return kInvalidId;
+}
+
+// ==========================================
+// AsyncChannel
+// ==========================================
+
+void EventBusImpl::AsyncChannel::run() {
+    std::string thread_name = "async:" + owner;
+    pthread_setname_np(pthread_self(), thread_name.substr(0, 15).c_str());
+
+    uint32_t idle = 0;
+    for (;;) {
+        bool got = queue.try_pop([](AsyncEntry& e) {
+            e.target.fn(e.target.ctx, e.pooled ? static_cast<const void*>(e.event) : e.event->data());
+            EventPool::release(e.event);
+        });
+        if (got) {
+            idle = 0;
+            continue;
+        }
+        // 先排空再退出
+        if (!running.load(std::memory_order_acquire)) break;
+
+        // 观察者不在热路径上：短暂自旋后让出 CPU
+        if (++idle < 256) {
+            _mm_pause();
+        } else if (idle < 1024) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+// 异步订阅者在委托表里是引用订阅者：收到池化的事件，入队前加一次引用，不拷贝载荷
+void EventBusImpl::enqueue_async(void* ctx, const void* data) {
+    auto* sub = static_cast<AsyncSubscription*>(ctx);
+    auto* event = const_cast<PooledEvent*>(static_cast<const PooledEvent*>(data));
+    event->refs.fetch_add(1, std::memory_order_relaxed);
+    bool ok = sub->channel->queue.try_push([sub, event](AsyncEntry& e) {
+        e.target = sub->target;
+        e.event = event;
+        e.pooled = sub->pooled_target;
+    });
+    // 发布线程绝不阻塞：队列满时丢弃并计数
+    if (!ok) {
+        EventPool::release(event);
+        sub->channel->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// ==========================================
+// MdShard
+// ==========================================
+
+void EventBusImpl::MdShard::run() {
+    std::string thread_name = "md_shard" + std::to_string(index);
+    pthread_setname_np(pthread_self(), thread_name.c_str());
+
+    if (core >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(core, &cpuset);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0) {
+            std::cerr << "[EventBus] " << thread_name << " 绑定 CPU " << core << " 失败" << std::endl;
+        }
+    }
+
+    const SymbolTable& symtab = *symbols;
+    for (;;) {
+        bool got = queue.try_pop([this, &symtab](TickRecord& tick) {
+            // 每条行情读取一次当前快照，运行期挂载/卸载的模块在下一条生效
+            rcu::ReadGuard guard;
+            const SubscriberList* subs = table->load(std::memory_order_acquire);
+            dispatch(EVENT_MARKET_DATA, subs->data(), subs->data() + subs->size(), &tick, symtab, pool);
+        });
+        if (got) continue;
+        if (!running.load(std::memory_order_acquire)) break;
+        // 分片线程在交易热路径上，保持自旋
+        _mm_pause();
+    }
+}
+
+// 调用方持有读端临界区：stop() 在停止分片线程前等待宽限期，在途的投递都能被分片线程取走
+void EventBusImpl::dispatch_sharded(const ShardList& shards, const TickRecord& tick) {
+    uint32_t h = symbol_hash(tick.symbol, sizeof(tick.symbol));
+    MdShard* shard = shards[h % shards.size()].get();
+    // 行情不能丢：队列满时在发布线程上自旋等待 (背压)；分片已在停止时改为在发布线程上直接分发
+    while (!shard->queue.push(tick)) {
+        if (!shard->running.load(std::memory_order_acquire)) {
+            const SubscriberList* subs = md_sharded_.load(std::memory_order_acquire);
+            dispatch(EVENT_MARKET_DATA, subs->data(), subs->data() + subs->size(), &tick, symbols_,
+                     pools_[EVENT_MARKET_DATA].get());
+            return;
+        }
+        _mm_pause();
+    }
+}
+
+// ==========================================
+// EventBusImpl
+// ==========================================
+
+EventBusImpl::EventBusImpl() {
+    for (auto& t : tables_) {
+        t.store(new SubscriberList(), std::memory_order_relaxed);
+    }
+    md_sharded_.store(new SubscriberList(), std::memory_order_relaxed);
+    md_serial_.store(new SubscriberList(), std::memory_order_relaxed);
+    configure_pools(kDefaultPoolCapacity);
+}
+
+EventBusImpl::~EventBusImpl() {
+    clear();
+    reap();
+    for (int i = 0; i < MAX_EVENTS; ++i) retire_pool(static_cast<EventType>(i), pools_[i]);
+    for (auto& t : tables_) {
+        delete t.load(std::memory_order_relaxed);
+    }
+    delete md_sharded_.load(std::memory_order_relaxed);
+    delete md_serial_.load(std::memory_order_relaxed);
+}
+
+void EventBusImpl::subscribe(EventType type, Handler handler) {
+    if (type < 0 || type >= MAX_EVENTS) return;
+    auto sub = std::make_unique<Subscription>();
+    sub->type = type;
+    sub->legacy = std::make_unique<Handler>(std::move(handler));
+    sub->entry.delegate = Delegate{&invoke_legacy, sub->legacy.get()};
+    add(std::move(sub), SymbolFilter());
+}
+
+void EventBusImpl::subscribe_delegate(EventType type, Delegate delegate, const SymbolFilter& filter) {
+    if (type < 0 || type >= MAX_EVENTS || !delegate.fn) return;
+    auto sub = std::make_unique<Subscription>();
+    sub->type = type;
+    sub->entry.delegate = delegate;
+    add(std::move(sub), filter);
+}
+
+void EventBusImpl::subscribe_batch_delegate(EventType type, BatchDelegate delegate, const SymbolFilter& filter) {
+    if (type < 0 || type >= MAX_EVENTS || !delegate.fn) return;
+    if (kPayloadSize[type] == 0) {
+        std::cerr << "[EventBus] " << event_name(type) << " 无固定载荷，不支持批量订阅" << std::endl;
+        return;
+    }
+    auto sub = std::make_unique<Subscription>();
+    sub->type = type;
+    sub->batch = std::make_unique<BatchDelegate>(delegate);
+    sub->entry.delegate = Delegate{&invoke_batch_single, sub->batch.get()};
+    sub->entry.batch = sub->batch.get();
+    add(std::move(sub), filter);
+}
+
+void EventBusImpl::subscribe_ref_delegate(EventType type, Delegate delegate, const SymbolFilter& filter) {
+    if (type < 0 || type >= MAX_EVENTS || !delegate.fn) return;
+    if (kPayloadSize[type] == 0) {
+        std::cerr << "[EventBus] " << event_name(type) << " 无固定载荷，不支持引用订阅" << std::endl;
+        return;
+    }
+    auto sub = std::make_unique<Subscription>();
+    sub->type = type;
+    sub->entry.delegate = delegate;
+    sub->entry.pooled = true;
+    add(std::move(sub), filter);
+}
+
+void EventBusImpl::add(std::unique_ptr<Subscription> sub, const SymbolFilter& filter) {
+    const EventType type = sub->type;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 归属与投递策略只对引擎正在初始化的模块生效，其它线程上的运行期订阅按 inline 处理
+        const bool in_init = !current_owner_.empty() && std::this_thread::get_id() == owner_thread_;
+        sub->owner = in_init ? current_owner_ : std::string();
+        const DeliveryPolicy policy = in_init ? current_policy_ : DeliveryPolicy();
+
+        // 过滤条件在订阅时一次性解析为位图
+        if (!filter.empty()) {
+            if (kSymbolOffset[type] == kNoSymbol) {
+                std::cerr << "[EventBus] " << event_name(type) << " 无 symbol 字段，忽略合约过滤" << std::endl;
+            } else {
+                sub->filter = std::make_unique<SymbolSet>();
+                for (const auto& sym : filter.symbols) {
+                    uint32_t id = symbols_.intern(sym.c_str());
+                    if (id != SymbolTable::kInvalidId) sub->filter->set(id);
+                }
+                sub->entry.filter = sub->filter.get();
+            }
+        }
+
+        bool async = policy.mode_for(type) == DeliveryMode::Async && in_init;
+        if (async && kPayloadSize[type] == 0) {
+            std::cerr << "[EventBus] " << sub->owner << ": " << event_name(type)
+                      << " 不支持异步投递，回退为 inline" << std::endl;
+            async = false;
+        }
+        if (latency_enabled_) sub->entry.stats = histogram_for(type, sub->owner, async);
+        sub->entry.shard_safe = policy.shard_safe;
+
+        if (async) {
+            sub->async = std::make_unique<AsyncSubscription>();
+            sub->async->channel = channel_for(sub->owner, policy.queue_capacity);
+            sub->async->target = sub->entry.delegate;
+            sub->async->pooled_target = sub->entry.pooled;
+            // 异步批量订阅者按条入队，消费线程以 count=1 回调
+            sub->entry.delegate = Delegate{&EventBusImpl::enqueue_async, sub->async.get()};
+            sub->entry.batch = nullptr;
+            sub->entry.pooled = true;
+            sub->entry.shard_safe = true; // 入队本身线程安全，回调仍在该模块唯一的消费线程上
+        }
+
+        // 按模块的分发顺序插入，同一顺序内排在已有订阅之后
+        const size_t rank = rank_of(sub->owner);
+        auto pos = std::find_if(subscriptions_.begin(), subscriptions_.end(),
+                                [this, rank](const std::unique_ptr<Subscription>& s) { return rank_of(s->owner) > rank; });
+        subscriptions_.insert(pos, std::move(sub));
+        republish(type);
+    }
+    reclaim();
+}
+
+size_t EventBusImpl::rank_of(const std::string& owner) const {
+    for (size_t i = 0; i < dispatch_order_.size(); ++i) {
+        if (dispatch_order_[i] == owner) return i;
+    }
+    return dispatch_order_.size();
+}
+
+void EventBusImpl::set_dispatch_order(const std::vector<std::string>& owners) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dispatch_order_ = owners;
+        std::stable_sort(subscriptions_.begin(), subscriptions_.end(),
+                         [this](const std::unique_ptr<Subscription>& a, const std::unique_ptr<Subscription>& b) {
+                             return rank_of(a->owner) < rank_of(b->owner);
+                         });
+        for (int i = 0; i < MAX_EVENTS; ++i) republish(static_cast<EventType>(i));
+    }
+    reclaim();
+}
+
+void EventBusImpl::republish(EventType type) {
+    auto next = std::make_unique<SubscriberList>();
+    for (const auto& sub : subscriptions_) {
+        if (sub->type == type) next->push_back(sub->entry);
+    }
+    const SubscriberList* prev = tables_[type].exchange(next.release(), std::memory_order_acq_rel);
+    retired_.tables.emplace_back(prev);
+    if (type != EVENT_MARKET_DATA) return;
+
+    auto sharded = std::make_unique<SubscriberList>();
+    auto serial = std::make_unique<SubscriberList>();
+    for (const Subscriber& s : *tables_[type].load(std::memory_order_relaxed)) {
+        (s.shard_safe ? sharded : serial)->push_back(s);
+    }
+    retired_.tables.emplace_back(md_sharded_.exchange(sharded.release(), std::memory_order_acq_rel));
+    retired_.tables.emplace_back(md_serial_.exchange(serial.release(), std::memory_order_acq_rel));
+}
+
+void EventBusImpl::reclaim() {
+    // 在回调中 (读端) 无法等待宽限期，留给下一次写操作
+    if (rcu::in_read_section()) return;
+
+    Retired batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (retired_.empty()) return;
+        std::swap(batch, retired_);
+    }
+    rcu::synchronize();
+
+    // 宽限期后不会再有发布者向这些队列投递，排空后再释放
+    // 在某个队列自己的消费线程上 (其回调中) 不能 join 自身，只通知退出，交给 reap()
+    for (auto& ch : batch.channels) {
+        ch->running.store(false, std::memory_order_release);
+        if (ch->worker.get_id() == std::this_thread::get_id()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            deferred_.push_back(std::move(ch));
+            continue;
+        }
+        if (ch->worker.joinable()) ch->worker.join();
+    }
+    // 分片线程在 stop() 中已退出 (在分片自己的回调中停止时除外，此时该线程不能被回收，列表不释放)
+    for (auto& shards : batch.shards) {
+        for (auto& shard : *shards) {
+            if (shard->worker.get_id() == std::this_thread::get_id()) {
+                shards.release();
+                break;
+            }
+            if (shard->worker.joinable()) shard->worker.join();
+        }
+    }
+}
+
+void EventBusImpl::reap() {
+    std::vector<std::unique_ptr<AsyncChannel>> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto keep = deferred_.begin();
+        for (auto it = deferred_.begin(); it != deferred_.end(); ++it) {
+            if ((*it)->worker.get_id() == std::this_thread::get_id()) {
+                *keep++ = std::move(*it);
+            } else {
+                batch.push_back(std::move(*it));
+            }
+        }
+        deferred_.erase(keep, deferred_.end());
+    }
+    for (auto& ch : batch) {
+        if (ch->worker.joinable()) ch->worker.join();
+    }
+}
+
+bool EventBusImpl::remove_module(const std::string& owner) {
+    if (owner.empty() || rcu::in_read_section()) return false;
+
+    size_t removed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::array<bool, MAX_EVENTS> touched{};
+        auto keep = subscriptions_.begin();
+        for (auto it = subscriptions_.begin(); it != subscriptions_.end(); ++it) {
+            if ((*it)->owner == owner) {
+                touched[(*it)->type] = true;
+                retired_.subscriptions.push_back(std::move(*it));
+                removed++;
+            } else {
+                *keep++ = std::move(*it);
+            }
+        }
+        subscriptions_.erase(keep, subscriptions_.end());
+        for (int i = 0; i < MAX_EVENTS; ++i) {
+            if (touched[i]) republish(static_cast<EventType>(i));
+        }
+
+        for (auto it = channels_.begin(); it != channels_.end(); ++it) {
+            if ((*it)->owner == owner) {
+                retired_.channels.push_back(std::move(*it));
+                channels_.erase(it);
+                break;
+            }
+        }
+    }
+    reclaim();
+
+    std::cout << "[EventBus] 已摘除 " << owner << " 的 " << removed << " 个订阅" << std::endl;
+    return true;
+}
+
+EventBusImpl::AsyncChannel* EventBusImpl::channel_for(const std::string& owner, size_t capacity) {
+    for (auto& ch : channels_) {
+        if (ch->owner == owner) return ch.get();
+    }
+    channels_.push_back(std::make_unique<AsyncChannel>(owner, capacity));
+    AsyncChannel* ch = channels_.back().get();
+    std::cout << "[EventBus] " << owner << " 使用异步投递 (queue=" << ch->queue.capacity() << ")" << std::endl;
+    if (started_) {
+        ch->running = true;
+        ch->worker = std::thread(&AsyncChannel::run, ch);
+    }
+    return ch;
+}
+
+void EventBusImpl::publish(EventType type, const void* data) {
+    if (type < 0 || type >= MAX_EVENTS) return;
+    rcu::ReadGuard guard;
+    const ShardList* shards = type == EVENT_MARKET_DATA ? active_shards_.load(std::memory_order_acquire) : nullptr;
+    if (shards) {
+        // 未声明 shard_safe 的行情订阅者仍在发布线程上串行回调，与不分片时相同
+        const SubscriberList* serial = md_serial_.load(std::memory_order_acquire);
+        dispatch(type, serial->data(), serial->data() + serial->size(), data, symbols_, pools_[type].get());
+        if (!md_sharded_.load(std::memory_order_acquire)->empty()) {
+            dispatch_sharded(*shards, *static_cast<const TickRecord*>(data));
+        }
+        return;
+    }
+    const SubscriberList* subs = tables_[type].load(std::memory_order_acquire);
+    dispatch(type, subs->data(), subs->data() + subs->size(), data, symbols_, pools_[type].get());
+}
+
+void EventBusImpl::publish_batch(EventType type, const void* data, size_t count) {
+    if (type < 0 || type >= MAX_EVENTS || count == 0) return;
+    const size_t stride = kPayloadSize[type];
+    if (stride == 0) return;
+
+    const char* base = static_cast<const char*>(data);
+    rcu::ReadGuard guard;
+    const ShardList* shards = type == EVENT_MARKET_DATA ? active_shards_.load(std::memory_order_acquire) : nullptr;
+    if (shards) {
+        // 串行订阅者在发布线程上按批分发，shard_safe 订阅者逐条分到各分片
+        deliver_list(type, md_serial_.load(std::memory_order_acquire), base, count);
+        if (md_sharded_.load(std::memory_order_acquire)->empty()) return;
+        const TickRecord* ticks = static_cast<const TickRecord*>(data);
+        for (size_t i = 0; i < count; ++i) dispatch_sharded(*shards, ticks[i]);
+        return;
+    }
+    deliver_list(type, tables_[type].load(std::memory_order_acquire), base, count);
+}
+
+void EventBusImpl::deliver_list(EventType type, const SubscriberList* subs, const char* base, size_t count) const {
+    const size_t stride = kPayloadSize[type];
+    const Subscriber* s = subs->data();
+    const Subscriber* end = s + subs->size();
+    while (s != end) {
+        if (s->batch) {
+            deliver_batch(type, *s, base, count);
+            ++s;
+            continue;
+        }
+        // 相邻的逐条订阅者按记录主序分发，与逐条 publish 的语义一致
+        const Subscriber* run_end = s;
+        while (run_end != end && !run_end->batch) ++run_end;
+        for (size_t i = 0; i < count; ++i) {
+            dispatch(type, s, run_end, base + i * stride, symbols_, pools_[type].get());
+        }
+        s = run_end;
+    }
+}
+
+void EventBusImpl::deliver_batch(EventType type, const Subscriber& sub, const char* data, size_t count) const {
+    const BatchDelegate& batch = *sub.batch;
+    if (!sub.filter) {
+        invoke_batch(sub.stats, batch, data, count);
+        return;
+    }
+
+    // 有过滤时，把命中的连续区间分段投递
+    const size_t stride = kPayloadSize[type];
+    const size_t sym_off = kSymbolOffset[type];
+    size_t run_start = 0;
+    bool in_run = false;
+    for (size_t i = 0; i < count; ++i) {
+        bool hit = sub.filter->test(symbols_.find(data + i * stride + sym_off));
+        if (hit && !in_run) {
+            run_start = i;
+            in_run = true;
+        } else if (!hit && in_run) {
+            invoke_batch(sub.stats, batch, data + run_start * stride, i - run_start);
+            in_run = false;
+        }
+    }
+    if (in_run) invoke_batch(sub.stats, batch, data + run_start * stride, count - run_start);
+}
+
+void EventBusImpl::dispatch(EventType type, const Subscriber* begin, const Subscriber* end,
+                            const void* data, const SymbolTable& symbols, EventPool* pool) {
+    // 只有遇到带过滤的订阅者才查表，且每次发布最多查一次
+    uint32_t sid = SymbolTable::kInvalidId;
+    bool resolved = false;
+    // 同理，只有遇到引用/异步订阅者才把载荷放进事件池，所有这类订阅者共享同一个槽位
+    PooledEvent* event = nullptr;
+    // 相邻的计时回调共用时间戳：上一个回调的结束时刻即下一个的起点，每个回调只多一次 rdtsc
+    uint64_t tsc = 0;
+    for (const Subscriber* s = begin; s != end; ++s) {
+        if (s->filter) {
+            if (!resolved) {
+                sid = symbols.find(static_cast<const char*>(data) + kSymbolOffset[type]);
+                resolved = true;
+            }
+            if (!s->filter->test(sid)) continue;
+        }
+        const void* arg = data;
+        if (s->pooled) {
+            if (!event) event = pool->acquire(data);
+            arg = event;
+        }
+        if (s->stats) {
+            if (!tsc) tsc = __rdtsc();
+            s->delegate.fn(s->delegate.ctx, arg);
+            uint64_t now = __rdtsc();
+            s->stats->record(now - tsc);
+            tsc = now;
+        } else {
+            s->delegate.fn(s->delegate.ctx, arg);
+            tsc = 0;
+        }
+    }
+    // 发布方的引用在分发结束时释放，槽位随最后一个持有者归还
+    if (event) EventPool::release(event);
+}
+
+void EventBusImpl::begin_module(const std::string& owner, const DeliveryPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_owner_ = owner;
+    current_policy_ = policy;
+    owner_thread_ = std::this_thread::get_id();
+}
+
+void EventBusImpl::end_module() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_owner_.clear();
+    current_policy_ = DeliveryPolicy();
+    owner_thread_ = std::thread::id();
+}
+
+void EventBusImpl::configure_pools(size_t capacity) {
+    if (started_) return;
+    for (int i = 0; i < MAX_EVENTS; ++i) {
+        retire_pool(static_cast<EventType>(i), pools_[i]);
+        pools_[i] = kPayloadSize[i] ? std::make_unique<EventPool>(kPayloadSize[i], capacity) : nullptr;
+    }
+}
+
+// 释放事件池。模块仍持有 EventRef 时 (例如模块析构晚于总线) 不释放内存，
+// 以免之后归还槽位时写入已释放的池；报告持有数，这部分内存随进程退出回收
+void EventBusImpl::retire_pool(EventType type, std::unique_ptr<EventPool>& pool) {
+    if (!pool) return;
+    size_t held = pool->outstanding();
+    if (held > 0) {
+        std::cerr << "[EventBus] " << event_name(type) << " 事件池仍有 " << held << " 个槽位被持有，不释放" << std::endl;
+        pool.release();
+        return;
+    }
+    pool.reset();
+}
+
+uint64_t EventBusImpl::pool_overflow(EventType type) const {
+    return type < MAX_EVENTS && pools_[type] ? pools_[type]->overflow() : 0;
+}
+
+void EventBusImpl::configure_sharding(const ShardingConfig& config) {
+    if (started_) return;
+    shards_.reset();
+    if (config.shards <= 0) return;
+    shards_ = std::make_unique<ShardList>();
+    for (int i = 0; i < config.shards; ++i) {
+        int core = i < (int)config.cores.size() ? config.cores[i] : -1;
+        shards_->push_back(std::make_unique<MdShard>(i, core, config.queue_capacity));
+    }
+    std::cout << "[EventBus] 行情分片: " << shards_->size() << " 个工作线程" << std::endl;
+}
+
+void EventBusImpl::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_) return;
+    for (auto& ch : channels_) {
+        ch->running = true;
+        ch->worker = std::thread(&AsyncChannel::run, ch.get());
+    }
+    if (shards_) {
+        for (auto& shard : *shards_) {
+            shard->table = &md_sharded_;
+            shard->symbols = &symbols_;
+            shard->pool = pools_[EVENT_MARKET_DATA].get();
+            shard->running = true;
+            shard->worker = std::thread(&MdShard::run, shard.get());
+        }
+        active_shards_.store(shards_.get(), std::memory_order_release);
+        std::cout << "[EventBus] 行情分片: " << md_sharded_.load(std::memory_order_relaxed)->size()
+                  << " 个 shard_safe 订阅在分片线程上分发，" << md_serial_.load(std::memory_order_relaxed)->size()
+                  << " 个在发布线程上串行分发" << std::endl;
+    }
+    started_ = true;
+}
+
+void EventBusImpl::stop() {
+    // 消费线程的回调里可能再订阅，等待线程退出时不能持有写锁
+    std::vector<AsyncChannel*> channels;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_) return;
+        started_ = false;
+        for (auto& ch : channels_) channels.push_back(ch.get());
+    }
+
+    // 分片线程会向异步队列投递，先停分片：新的发布不再进入分片，等在途的发布者退出后才停分片线程，
+    // 之前投递的行情都会被取走。在回调中停止时无法等待宽限期，发布者发现分片已停止会改为直接分发，
+    // 分片线程退出后才入队的行情在这里补发
+    if (active_shards_.exchange(nullptr, std::memory_order_acq_rel)) {
+        if (!rcu::in_read_section()) rcu::synchronize();
+        for (auto& shard : *shards_) {
+            shard->running.store(false, std::memory_order_release);
+        }
+        rcu::ReadGuard guard;
+        const SubscriberList* subs = md_sharded_.load(std::memory_order_acquire);
+        auto deliver = [&](TickRecord& tick) {
+            dispatch(EVENT_MARKET_DATA, subs->data(), subs->data() + subs->size(), &tick, symbols_,
+                     pools_[EVENT_MARKET_DATA].get());
+        };
+        for (auto& shard : *shards_) {
+            if (shard->worker.get_id() == std::this_thread::get_id()) continue; // 分片自己的回调中停止
+            if (shard->worker.joinable()) shard->worker.join();
+            while (shard->queue.try_pop(deliver)) {
+            }
+        }
+    }
+    for (auto* ch : channels) {
+        ch->running.store(false, std::memory_order_release);
+    }
+    for (auto* ch : channels) {
+        // 在消费线程自己的回调中停止时不 join 自身，之后由 clear()/reap() 回收
+        if (ch->worker.joinable() && ch->worker.get_id() != std::this_thread::get_id()) ch->worker.join();
+        uint64_t dropped = ch->dropped.load();
+        if (dropped > 0) {
+            std::cerr << "[EventBus] " << ch->owner << " 异步队列满，丢弃事件: " << dropped << std::endl;
+        }
+    }
+    for (int i = 0; i < MAX_EVENTS; ++i) {
+        uint64_t overflow = pools_[i] ? pools_[i]->overflow() : 0;
+        if (overflow > 0) {
+            std::cerr << "[EventBus] " << event_name(static_cast<EventType>(i)) << " 事件池耗尽，堆分配: "
+                      << overflow << " (capacity=" << pools_[i]->capacity() << ")" << std::endl;
+        }
+    }
+}
+
+bool EventBusImpl::add_poller(const std::string& thread_name, Poller poller) {
+    if (!threads_) return false;
+    return threads_->add_poller(thread_name, current_owner_, poller);
+}
+
+uint64_t EventBusImpl::async_dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t total = 0;
+    for (auto& ch : channels_) total += ch->dropped.load(std::memory_order_relaxed);
+    return total;
+}
+
+LatencyHistogram* EventBusImpl::histogram_for(EventType type, const std::string& owner, bool async) {
+    const std::string key = owner.empty() ? "-" : owner;
+    for (auto& e : latency_) {
+        if (e.type == type && e.async == async && e.owner == key) return e.histogram.get();
+    }
+    latency_.push_back(LatencyEntry{type, key, async, std::make_unique<LatencyHistogram>()});
+    return latency_.back().histogram.get();
+}
+
+void EventBusImpl::enable_latency_stats() {
+    if (latency_enabled_) return;
+    latency_enabled_ = true;
+    // 提前标定 TSC 频率，避免首次查询时阻塞
+    tsc_ns_per_cycle();
+    std::cout << "[EventBus] 回调耗时统计已开启" << std::endl;
+}
+
+std::vector<HandlerLatency> EventBusImpl::latency_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<HandlerLatency> out;
+    if (latency_.empty()) return out;
+    const double ns = tsc_ns_per_cycle();
+    out.reserve(latency_.size());
+    for (const auto& e : latency_) {
+        const LatencyHistogram& h = *e.histogram;
+        HandlerLatency l;
+        l.type = e.type;
+        l.module = e.owner;
+        l.async = e.async;
+        l.count = h.count();
+        l.p50_ns = h.percentile(0.50) * ns;
+        l.p99_ns = h.percentile(0.99) * ns;
+        l.p999_ns = h.percentile(0.999) * ns;
+        l.max_ns = h.max() * ns;
+        out.push_back(std::move(l));
+    }
+    return out;
+}
+
+void EventBusImpl::clear() {
+    // 消费线程仍可能持有委托，必须先停下
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& sub : subscriptions_) retired_.subscriptions.push_back(std::move(sub));
+        subscriptions_.clear();
+        for (int i = 0; i < MAX_EVENTS; ++i) republish(static_cast<EventType>(i));
+        for (auto& ch : channels_) retired_.channels.push_back(std::move(ch));
+        channels_.clear();
+        // 发布者可能仍持有分片列表，宽限期后才释放
+        if (shards_) retired_.shards.push_back(std::move(shards_));
+    }
+    reclaim();
+
+    // 直方图被旧快照引用，宽限期之后才能释放
+    std::lock_guard<std::mutex> lock(mutex_);
+    latency_.clear();
+}
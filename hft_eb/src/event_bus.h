@@ -0,0 +1,276 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/framework.h"
+#include "mpsc_queue.h"
+#include "latency_stats.h"
+#include "event_pool.h"
+
+class ThreadModel;
+
+// 订阅的投递方式
+enum class DeliveryMode {
+    Inline, // 在发布线程上同步调用 (默认，热路径)
+    Async   // 拷贝进订阅者专属队列，由其消费线程调用
+};
+
+// 每个模块的投递策略，由引擎根据插件配置中的 "delivery" 字段生成
+struct DeliveryPolicy {
+    DeliveryMode default_mode = DeliveryMode::Inline;
+    std::array<int, MAX_EVENTS> per_event;   // -1 表示沿用 default_mode
+    size_t queue_capacity = 4096;            // 异步队列容量 (2 的幂)
+    bool shard_safe = false;                 // 行情回调可在多个分片线程上并发执行 (插件配置 "shard_safe")
+
+    DeliveryPolicy() { per_event.fill(-1); }
+
+    DeliveryMode mode_for(EventType type) const {
+        return per_event[type] < 0 ? default_mode : static_cast<DeliveryMode>(per_event[type]);
+    }
+};
+
+// 行情按合约哈希分片到多个工作线程 (顶层配置 "md_sharding")
+struct ShardingConfig {
+    int shards = 0;                // 0 表示关闭，在发布线程上直接分发
+    std::vector<int> cores;        // 每个分片绑定的 CPU，缺省不绑核
+    size_t queue_capacity = 8192;  // 每个分片队列容量 (2 的幂)
+};
+
+// 合约驻留表：合约名 -> 稠密 ID，仅在订阅时插入，发布时只读查找
+// 固定容量开放寻址，槽位用原子状态发布，查找无锁
+class SymbolTable {
+public:
+    static constexpr uint32_t kInvalidId = 0xFFFFFFFFu;
+    static constexpr size_t kSlots = 8192; // 2 的幂，最多容纳一半的合约数
+
+    SymbolTable();
+
+    uint32_t intern(const char* symbol);
+    uint32_t find(const char* symbol) const;
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> state{0}; // 0 空, 1 写入中, 2 就绪
+        uint32_t id = 0;
+        char symbol[32] = {0};
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint32_t> next_id_{0};
+};
+
+// 订阅时解析出的合约位图
+struct SymbolSet {
+    std::vector<uint64_t> bits;
+
+    void set(uint32_t id) {
+        if ((id >> 6) >= bits.size()) bits.resize((id >> 6) + 1, 0);
+        bits[id >> 6] |= 1ull << (id & 63);
+    }
+    bool test(uint32_t id) const {
+        size_t w = id >> 6;
+        return w < bits.size() && ((bits[w] >> (id & 63)) & 1);
+    }
+};
+
+// 订阅表项：委托 + 可选过滤位图
+// 批量订阅者的 delegate 是一个把单条载荷转成 count=1 的 thunk，publish_batch 时改用 batch
+struct Subscriber {
+    Delegate delegate;
+    const SymbolSet* filter = nullptr;     // nullptr 表示不过滤
+    const BatchDelegate* batch = nullptr;  // 非空表示批量订阅者
+    LatencyHistogram* stats = nullptr;     // 非空时记录每次回调的 TSC 耗时
+    bool pooled = false;                   // true 表示委托收到 PooledEvent* 而不是载荷指针
+    bool shard_safe = false;               // 开启行情分片时可在分片线程上并发回调，否则在发布线程上串行回调
+};
+
+// 解析事件名 ("EVENT_MARKET_DATA" 或简写 "MARKET_DATA")
+bool parse_event_type(const std::string& name, EventType& out);
+
+// --- EventBus 实现 ---
+// 每个事件类型对应一张委托表 (函数指针 + ctx)，publish 只做一次虚调用，
+// 之后对每个订阅者是一次普通的间接调用，由 thunk 内联真正的处理函数。
+// 异步订阅同样是表里的一个委托，只是它的 thunk 把载荷拷进队列后立即返回。
+//
+// 委托表是不可变快照，通过原子指针发布 (RCU)：publish 只在 RCU 读端加载指针，不加锁；
+// 订阅/卸载在写锁下复制出新表并替换，旧表及被摘除的订阅资源在宽限期结束后释放。
+// 因此引擎运行期间可以安全地挂载或卸载模块。
+class EventBusImpl : public EventBus {
+public:
+    EventBusImpl();
+    ~EventBusImpl() override;
+
+    void subscribe(EventType type, Handler handler) override;
+    void subscribe_delegate(EventType type, Delegate delegate, const SymbolFilter& filter) override;
+    void publish(EventType type, const void* data) override;
+    void subscribe_batch_delegate(EventType type, BatchDelegate delegate, const SymbolFilter& filter) override;
+    void publish_batch(EventType type, const void* data, size_t count) override;
+    void subscribe_ref_delegate(EventType type, Delegate delegate, const SymbolFilter& filter) override;
+    void clear() override;
+    bool add_poller(const std::string& thread_name, Poller poller) override;
+    std::vector<HandlerLatency> latency_stats() const override;
+    uint64_t pool_overflow(EventType type) const override;
+
+    // 摘除某个模块的全部订阅，等待在途回调结束并排空其异步队列后返回
+    // 返回后总线不再持有该模块的任何委托，可以安全销毁模块。不能在事件回调中调用
+    // (例外：在该模块自己的异步消费线程上调用时不 join 自身，线程排空队列后退出，由 reap() 回收)
+    bool remove_module(const std::string& owner);
+
+    // 回收在自身消费线程上被摘除的异步队列 (join 线程并释放)，由引擎控制线程周期调用
+    void reap();
+
+    // 开启回调耗时统计，须在模块 init() 之前调用，只对之后的订阅生效
+    void enable_latency_stats();
+
+    // 由引擎注入线程模型，add_poller 转发给它；未注入时 add_poller 总是返回 false
+    void set_thread_model(ThreadModel* threads) { threads_ = threads; }
+
+    // 引擎在调用 IModule::init 前后设置当前模块，用于归属订阅与选择投递方式
+    // 只对调用 begin_module 的线程上发生的订阅生效
+    void begin_module(const std::string& owner, const DeliveryPolicy& policy);
+    void end_module();
+
+    // 设置模块的分发顺序 (由引擎按依赖声明拓扑排序得到)，同一事件的回调按此顺序调用
+    // 未列出的模块 (以及不属于任何模块的订阅) 排在最后，相互之间保持订阅顺序
+    void set_dispatch_order(const std::vector<std::string>& owners);
+
+    // 重新分配各事件类型的事件池 (每类 capacity 个槽位)，须在任何发布之前调用
+    void configure_pools(size_t capacity);
+
+    // 开启行情分片，须在 start() 之前调用
+    void configure_sharding(const ShardingConfig& config);
+
+    // 启动/停止异步消费线程与分片线程 (停止时会先排空队列)
+    void start();
+    void stop();
+
+    // 因队列满而丢弃的异步事件总数
+    uint64_t async_dropped() const;
+
+private:
+    // 队列里只放事件池槽位的指针，槽位在消费线程回调结束后释放
+    struct AsyncEntry {
+        Delegate target;
+        PooledEvent* event;
+        bool pooled; // 目标是引用订阅者，直接传 PooledEvent*
+    };
+
+    // 一个模块的所有异步订阅共享一条队列和一个消费线程，保证该模块内部事件有序
+    struct AsyncChannel {
+        explicit AsyncChannel(const std::string& name, size_t capacity) : owner(name), queue(capacity) {}
+        // 消费线程退出后才入队的事件不再回调，只归还槽位
+        ~AsyncChannel() {
+            while (queue.try_pop([](AsyncEntry& e) { EventPool::release(e.event); })) {
+            }
+        }
+        void run();
+
+        std::string owner;
+        MpscQueue<AsyncEntry> queue;
+        std::thread worker;
+        std::atomic<bool> running{false};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    struct AsyncSubscription {
+        AsyncChannel* channel;
+        Delegate target;
+        bool pooled_target;
+    };
+
+    // 行情分片：同一合约总是落在同一分片，保证单合约内有序
+    struct MdShard {
+        MdShard(int idx, int cpu, size_t capacity) : index(idx), core(cpu), queue(capacity) {}
+        void run();
+
+        int index;
+        int core;
+        MpscQueue<TickRecord> queue;
+        const std::atomic<const std::vector<Subscriber>*>* table = nullptr; // shard_safe 行情订阅表的快照指针
+        const SymbolTable* symbols = nullptr;
+        EventPool* pool = nullptr;
+        std::thread worker;
+        std::atomic<bool> running{false};
+    };
+
+    using SubscriberList = std::vector<Subscriber>;
+    using ShardList = std::vector<std::unique_ptr<MdShard>>;
+
+    // 一次订阅拥有的全部资源，随所属模块卸载，在宽限期结束后释放
+    struct Subscription {
+        EventType type;
+        std::string owner;
+        Subscriber entry;
+        std::unique_ptr<SymbolSet> filter;
+        std::unique_ptr<Handler> legacy;       // 旧接口适配：std::function 由总线持有，委托 ctx 指向它
+        std::unique_ptr<BatchDelegate> batch;
+        std::unique_ptr<AsyncSubscription> async;
+    };
+
+    // 等待宽限期后释放的对象
+    struct Retired {
+        std::vector<std::unique_ptr<const SubscriberList>> tables;
+        std::vector<std::unique_ptr<Subscription>> subscriptions;
+        std::vector<std::unique_ptr<AsyncChannel>> channels;
+        std::vector<std::unique_ptr<ShardList>> shards;
+
+        bool empty() const { return tables.empty() && subscriptions.empty() && channels.empty() && shards.empty(); }
+    };
+
+    // 每个 (事件, 模块) 一个直方图，同一模块对同一事件的多次订阅共用
+    struct LatencyEntry {
+        EventType type;
+        std::string owner;
+        bool async;
+        std::unique_ptr<LatencyHistogram> histogram;
+    };
+
+    static void enqueue_async(void* ctx, const void* data);
+    void dispatch_sharded(const ShardList& shards, const TickRecord& tick);
+    void add(std::unique_ptr<Subscription> sub, const SymbolFilter& filter);
+    void republish(EventType type);
+    size_t rank_of(const std::string& owner) const;
+    void reclaim();
+    static void retire_pool(EventType type, std::unique_ptr<EventPool>& pool);
+    void deliver_batch(EventType type, const Subscriber& sub, const char* data, size_t count) const;
+    void deliver_list(EventType type, const SubscriberList* subs, const char* base, size_t count) const;
+    static void dispatch(EventType type, const Subscriber* begin, const Subscriber* end,
+                         const void* data, const SymbolTable& symbols, EventPool* pool);
+    AsyncChannel* channel_for(const std::string& owner, size_t capacity);
+    LatencyHistogram* histogram_for(EventType type, const std::string& owner, bool async);
+
+    // 读端：每个事件一张不可变的委托表快照
+    std::array<std::atomic<const SubscriberList*>, MAX_EVENTS> tables_;
+    // 开启行情分片时行情订阅表按 shard_safe 拆成两张：分片线程只调用前者，其余在发布线程上串行调用
+    std::atomic<const SubscriberList*> md_sharded_;
+    std::atomic<const SubscriberList*> md_serial_;
+
+    // 写端：以下成员都由 mutex_ 保护
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Subscription>> subscriptions_; // 按分发顺序 (同一模块内按订阅顺序)
+    std::vector<std::string> dispatch_order_;
+    Retired retired_;
+    std::vector<std::unique_ptr<AsyncChannel>> channels_;
+    std::vector<std::unique_ptr<AsyncChannel>> deferred_; // 等待 reap() 回收的异步队列
+
+    SymbolTable symbols_;
+    std::array<std::unique_ptr<EventPool>, MAX_EVENTS> pools_; // 无固定载荷的事件为空
+
+    std::unique_ptr<ShardList> shards_;                     // 写端持有，configure_sharding 创建
+    std::atomic<const ShardList*> active_shards_{nullptr};  // 读端：运行中的分片，与订阅表同受 RCU 保护
+
+    ThreadModel* threads_ = nullptr;
+
+    bool latency_enabled_ = false;
+    std::vector<LatencyEntry> latency_;
+
+    std::string current_owner_;
+    std::thread::id owner_thread_;
+    DeliveryPolicy current_policy_;
+    bool started_ = false;
+};
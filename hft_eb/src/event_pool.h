@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include "../include/framework.h"
+
+// --- 事件池 ---
+// 每个事件类型一个，启动时一次性分配 capacity 个槽位 (64 字节头部 + 按缓存行对齐的载荷)。
+// 空闲槽位挂在带版本号的 Treiber 栈上，发布线程取、任意持有者归还，全程无锁。
+// 池空时退化为堆分配并计数 (首次耗尽时告警，计数经 EventBus::pool_overflow 查询)，保证不丢事件。
+// 槽位被订阅者持有 (EventRef) 时池不能释放，销毁前用 outstanding() 检查。
+class EventPool {
+public:
+    EventPool(size_t payload_size, size_t capacity)
+        : payload_size_(payload_size),
+          stride_(sizeof(PooledEvent) + round_up(payload_size)),
+          capacity_(capacity),
+          next_(new std::atomic<uint32_t>[capacity]) {
+        storage_ = static_cast<unsigned char*>(std::aligned_alloc(alignof(PooledEvent), stride_ * capacity_));
+        if (!storage_) throw std::bad_alloc();
+        for (size_t i = 0; i < capacity_; ++i) {
+            PooledEvent* e = new (storage_ + i * stride_) PooledEvent();
+            e->recycle = &EventPool::recycle;
+            e->pool = this;
+            next_[i].store(static_cast<uint32_t>(i + 1), std::memory_order_relaxed);
+        }
+        free_head_.store(capacity_ > 0 ? 0 : kEmpty, std::memory_order_relaxed);
+        if (capacity_ > 0) next_[capacity_ - 1].store(kEmpty, std::memory_order_relaxed);
+    }
+
+    ~EventPool() {
+        for (size_t i = 0; i < capacity_; ++i) {
+            slot(static_cast<uint32_t>(i))->~PooledEvent();
+        }
+        std::free(storage_);
+    }
+
+    EventPool(const EventPool&) = delete;
+    EventPool& operator=(const EventPool&) = delete;
+
+    // 取一个槽位并拷入载荷，引用计数为 1 (归发布方所有，分发结束后 release)
+    PooledEvent* acquire(const void* data) {
+        PooledEvent* e = pop();
+        if (!e) {
+            if (overflow_.fetch_add(1, std::memory_order_relaxed) == 0) {
+                std::cerr << "[EventPool] 事件池耗尽 (capacity=" << capacity_ << ")，之后的事件改为堆分配" << std::endl;
+            }
+            void* mem = std::aligned_alloc(alignof(PooledEvent), stride_);
+            if (!mem) throw std::bad_alloc();
+            e = new (mem) PooledEvent();
+            e->recycle = &EventPool::free_heap;
+        }
+        std::memcpy(e->data(), data, payload_size_);
+        e->refs.store(1, std::memory_order_relaxed);
+        return e;
+    }
+
+    static void release(PooledEvent* e) {
+        if (e->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) e->recycle(e);
+    }
+
+    size_t capacity() const { return capacity_; }
+    uint64_t overflow() const { return overflow_.load(std::memory_order_relaxed); }
+
+    // 仍被持有的槽位数 (引用计数非 0)，归还到池的槽位引用计数为 0
+    size_t outstanding() const {
+        size_t n = 0;
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (slot(static_cast<uint32_t>(i))->refs.load(std::memory_order_acquire) != 0) n++;
+        }
+        return n;
+    }
+
+private:
+    static constexpr uint32_t kEmpty = 0xFFFFFFFFu;
+
+    static size_t round_up(size_t n) { return (n + alignof(PooledEvent) - 1) & ~(alignof(PooledEvent) - 1); }
+
+    PooledEvent* slot(uint32_t i) const { return reinterpret_cast<PooledEvent*>(storage_ + i * stride_); }
+    uint32_t index_of(const PooledEvent* e) const {
+        return static_cast<uint32_t>((reinterpret_cast<const unsigned char*>(e) - storage_) / stride_);
+    }
+
+    // 头部 = (版本号 << 32) | 下标，每次修改版本号加 1，避免 ABA
+    PooledEvent* pop() {
+        uint64_t head = free_head_.load(std::memory_order_acquire);
+        for (;;) {
+            uint32_t idx = static_cast<uint32_t>(head);
+            if (idx == kEmpty) return nullptr;
+            uint64_t next = ((head >> 32) + 1) << 32 | next_[idx].load(std::memory_order_relaxed);
+            if (free_head_.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire)) {
+                return slot(idx);
+            }
+        }
+    }
+
+    void push(PooledEvent* e) {
+        uint32_t idx = index_of(e);
+        uint64_t head = free_head_.load(std::memory_order_relaxed);
+        for (;;) {
+            next_[idx].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            uint64_t next = ((head >> 32) + 1) << 32 | idx;
+            if (free_head_.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    static void recycle(PooledEvent* e) { static_cast<EventPool*>(e->pool)->push(e); }
+
+    static void free_heap(PooledEvent* e) {
+        e->~PooledEvent();
+        std::free(e);
+    }
+
+    size_t payload_size_;
+    size_t stride_;
+    size_t capacity_;
+    unsigned char* storage_ = nullptr;
+    std::unique_ptr<std::atomic<uint32_t>[]> next_;
+    alignas(64) std::atomic<uint64_t> free_head_{kEmpty};
+    std::atomic<uint64_t> overflow_{0};
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <x86intrin.h> // __rdtsc
+
+// --- 回调耗时直方图 ---
+// 对数分桶：每个 2 的幂区间再细分 4 档，误差 < 25%，256 个桶覆盖完整的 uint64 范围。
+// 记录只有一次 relaxed fetch_add (max 仅在刷新时 CAS)，可以常开在生产环境。
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 2;
+    static constexpr int kBuckets = 64 << kSubBits;
+
+    LatencyHistogram() {
+        for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+    }
+
+    void record(uint64_t cycles) {
+        counts_[bucket_of(cycles)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t m = max_.load(std::memory_order_relaxed);
+        while (cycles > m && !max_.compare_exchange_weak(m, cycles, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (const auto& c : counts_) total += c.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // 分位数 (单位: cycles)，取所在桶的上界，并以实际最大值封顶
+    uint64_t percentile(double q) const {
+        uint64_t snapshot[kBuckets];
+        uint64_t total = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            snapshot[i] = counts_[i].load(std::memory_order_relaxed);
+            total += snapshot[i];
+        }
+        if (total == 0) return 0;
+
+        uint64_t target = static_cast<uint64_t>(q * total);
+        if (target == 0) target = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += snapshot[i];
+            if (seen >= target) {
+                uint64_t upper = (i + 1 < kBuckets) ? lower_bound(i + 1) - 1 : UINT64_MAX;
+                uint64_t m = max();
+                return upper < m ? upper : m;
+            }
+        }
+        return max();
+    }
+
+    static int bucket_of(uint64_t v) {
+        if (v < (1u << (kSubBits + 1))) return static_cast<int>(v);
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - kSubBits;
+        return ((shift + 1) << kSubBits) + static_cast<int>((v >> shift) & ((1u << kSubBits) - 1));
+    }
+
+    static uint64_t lower_bound(int bucket) {
+        if (bucket < (1 << (kSubBits + 1))) return static_cast<uint64_t>(bucket);
+        int shift = (bucket >> kSubBits) - 1;
+        uint64_t sub = bucket & ((1 << kSubBits) - 1);
+        return ((1ull << kSubBits) + sub) << shift;
+    }
+
+private:
+    std::atomic<uint64_t> counts_[kBuckets];
+    std::atomic<uint64_t> max_{0};
+};
+
+// TSC 频率标定：首次调用时用 steady_clock 对比约 20ms，返回每个 cycle 的纳秒数
+inline double tsc_ns_per_cycle() {
+    static const double ratio = [] {
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = __rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t c1 = __rdtsc();
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        return c1 > c0 ? ns / static_cast<double>(c1 - c0) : 1.0;
+    }();
+    return ratio;
+}
@@ -1,7 +1,15 @@
 #include <iostream>
 #include <thread>
+#include <csignal>
 #include "../include/engine.h"
 
+static HftEngine* g_engine = nullptr;
+
+// kill -HUP <pid>：按配置文件重新加载插件 (策略热替换)
+static void onSighup(int) {
+    if (g_engine) g_engine->requestReload();
+}
+
 int main(int argc, char* argv[]) {
     // 0. 基础环境准备
     std::thread([]{}).join(); // Force pthread init
@@ -17,6 +25,9 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    g_engine = &engine;
+    std::signal(SIGHUP, onSighup);
+
     // 3. 启动并运行
     // 默认运行 5 秒，或者可以修改 engine 接口支持一直运行直到信号中断
     engine.run(5);
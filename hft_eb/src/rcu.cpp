@@ -0,0 +1,94 @@
+#include "rcu.h"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <immintrin.h> // 用于 _mm_pause
+
+namespace rcu {
+namespace {
+
+bool init_membarrier() {
+    long mask = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0);
+    if (mask < 0 || !(mask & MEMBARRIER_CMD_PRIVATE_EXPEDITED)) return false;
+    return syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+}
+
+// 已注册的读者，synchronize() 持锁遍历
+std::mutex& registry_mutex() {
+    static std::mutex m;
+    return m;
+}
+
+std::vector<Reader*>& registry() {
+    static std::vector<Reader*> readers;
+    return readers;
+}
+
+// 线程退出时注销读者记录
+struct Registration {
+    Reader* reader = nullptr;
+    ~Registration() {
+        if (!reader) return;
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        auto& readers = registry();
+        readers.erase(std::remove(readers.begin(), readers.end(), reader), readers.end());
+        delete reader;
+        detail::tls_reader = nullptr;
+    }
+};
+
+// 写端全屏障：配合读端的编译器屏障 (membarrier) 或 fence 构成 Dekker 式的同步
+void full_barrier() {
+    if (detail::use_membarrier) {
+        syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+    } else {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+} // namespace
+
+namespace detail {
+thread_local Reader* tls_reader = nullptr;
+std::atomic<uint64_t> gp_ctr{1};
+const bool use_membarrier = init_membarrier();
+
+Reader* register_reader() {
+    static thread_local Registration registration;
+    registration.reader = new Reader();
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        registry().push_back(registration.reader);
+    }
+    tls_reader = registration.reader;
+    return tls_reader;
+}
+} // namespace detail
+
+void synchronize() {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    full_barrier();
+    const uint64_t target = detail::gp_ctr.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+    for (Reader* r : registry()) {
+        if (r == detail::tls_reader) continue; // 调用方保证自身不在读端
+        uint32_t spins = 0;
+        for (;;) {
+            uint64_t c = r->ctr.load(std::memory_order_acquire);
+            // 不在临界区，或是在代数推进后才进入 (必然看到新指针)
+            if (c == 0 || c >= target) break;
+            if (++spins < 1024) {
+                _mm_pause();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+    full_barrier();
+}
+
+} // namespace rcu
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// --- 用户态 RCU (Read-Copy-Update) ---
+// 读端 (publish / 分片线程) 无锁、无等待：进入时把全局代数写入本线程的读者记录，退出时清零，可嵌套。
+// 写端先原子替换指针，再调用 synchronize() 等待所有仍在旧代数中的读者退出，之后才能释放旧数据。
+// 内核支持 membarrier(2) 时读端只需编译器屏障，由写端通过系统调用让所有线程执行全屏障；
+// 否则读端退化为一次 seq_cst fence。
+namespace rcu {
+
+struct alignas(64) Reader {
+    std::atomic<uint64_t> ctr{0}; // 0 表示不在读端临界区，否则为进入时的全局代数
+    uint32_t nesting = 0;         // 仅本线程访问
+};
+
+namespace detail {
+extern thread_local Reader* tls_reader;
+extern std::atomic<uint64_t> gp_ctr; // 从 1 开始，每次 synchronize 加 1
+extern const bool use_membarrier;
+Reader* register_reader();           // 线程首次进入读端时注册，线程退出时自动注销
+} // namespace detail
+
+inline void read_lock() {
+    Reader* r = detail::tls_reader;
+    if (__builtin_expect(r == nullptr, 0)) r = detail::register_reader();
+    if (r->nesting++ == 0) {
+        r->ctr.store(detail::gp_ctr.load(std::memory_order_acquire), std::memory_order_relaxed);
+        // 读者记录必须先于之后对快照指针的读取对写端可见
+        if (detail::use_membarrier) {
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+}
+
+inline void read_unlock() {
+    Reader* r = detail::tls_reader;
+    if (--r->nesting == 0) r->ctr.store(0, std::memory_order_release);
+}
+
+// 当前线程是否处于读端临界区 (例如在事件回调中)；此时不能调用 synchronize()
+inline bool in_read_section() {
+    Reader* r = detail::tls_reader;
+    return r && r->nesting > 0;
+}
+
+// 等待宽限期：返回时，调用前已进入读端的线程都已退出
+void synchronize();
+
+class ReadGuard {
+public:
+    ReadGuard() { read_lock(); }
+    ~ReadGuard() { read_unlock(); }
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+};
+
+} // namespace rcu
@@ -0,0 +1,133 @@
+#include "thread_model.h"
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <immintrin.h> // 用于 _mm_pause
+
+ThreadModel::~ThreadModel() {
+    stop();
+}
+
+void ThreadModel::configure(const std::vector<ThreadSpec>& specs) {
+    if (started_) return;
+    threads_.clear();
+    for (const auto& spec : specs) {
+        if (find(spec.name)) {
+            std::cerr << "[Threads] 重复的线程名: " << spec.name << std::endl;
+            continue;
+        }
+        auto t = std::make_unique<EngineThread>();
+        t->spec = spec;
+        threads_.push_back(std::move(t));
+        std::cout << "[Threads] " << spec.name << ": core=" << spec.core
+                  << (spec.fifo ? " SCHED_FIFO prio=" + std::to_string(spec.priority) : std::string())
+                  << std::endl;
+    }
+}
+
+ThreadModel::EngineThread* ThreadModel::find(const std::string& name) {
+    for (auto& t : threads_) {
+        if (t->spec.name == name) return t.get();
+    }
+    return nullptr;
+}
+
+bool ThreadModel::add_poller(const std::string& thread_name, const std::string& owner, Poller poller) {
+    if (started_ || !poller.fn) return false;
+    EngineThread* t = find(thread_name);
+    if (!t) return false;
+    t->pollers.push_back(PollEntry{poller, owner});
+    std::cout << "[Threads] " << owner << " -> " << thread_name << std::endl;
+    return true;
+}
+
+bool ThreadModel::has_pollers(const std::string& owner) const {
+    for (const auto& t : threads_) {
+        for (const auto& p : t->pollers) {
+            if (p.owner == owner) return true;
+        }
+    }
+    return false;
+}
+
+void ThreadModel::start() {
+    if (started_) return;
+    for (auto& t : threads_) {
+        // "main" 在 run_main() 中由调用线程执行；没有轮询函数的线程不启动
+        if (t->spec.name == kMainThread || t->pollers.empty()) continue;
+        t->running = true;
+        t->worker = std::thread(&EngineThread::loop, t.get(), std::chrono::steady_clock::time_point::max());
+    }
+    started_ = true;
+}
+
+void ThreadModel::stop() {
+    for (auto& t : threads_) {
+        t->running.store(false, std::memory_order_release);
+    }
+    for (auto& t : threads_) {
+        if (t->worker.joinable()) t->worker.join();
+    }
+    started_ = false;
+}
+
+bool ThreadModel::run_main(std::chrono::steady_clock::time_point deadline) {
+    EngineThread* t = find(kMainThread);
+    if (!t || t->pollers.empty()) return false;
+    t->running = true;
+    t->loop(deadline);
+    return true;
+}
+
+void ThreadModel::EngineThread::apply_sched() {
+    pthread_setname_np(pthread_self(), spec.name.substr(0, 15).c_str());
+
+    if (spec.core >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(spec.core, &cpuset);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0) {
+            std::cerr << "[Threads] " << spec.name << " 绑定 CPU " << spec.core << " 失败" << std::endl;
+        }
+    }
+
+    if (spec.fifo) {
+        sched_param param{};
+        param.sched_priority = spec.priority;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+            std::cerr << "[Threads] " << spec.name << " 设置 SCHED_FIFO 失败 (需要 CAP_SYS_NICE)" << std::endl;
+        }
+    }
+}
+
+void ThreadModel::EngineThread::loop(std::chrono::steady_clock::time_point deadline) {
+    apply_sched();
+
+    const PollEntry* begin = pollers.data();
+    const PollEntry* end = begin + pollers.size();
+    const bool has_deadline = deadline != std::chrono::steady_clock::time_point::max();
+    uint32_t iter = 0;
+
+    while (running.load(std::memory_order_relaxed)) {
+        int work = 0;
+        for (const PollEntry* p = begin; p != end; ++p) {
+            work += p->poller.fn(p->poller.ctx);
+        }
+
+        // 每 1024 轮检查一次时钟，避免在热循环里频繁取时间
+        if (has_deadline && (++iter & 1023) == 0 && std::chrono::steady_clock::now() >= deadline) break;
+        if (work > 0) continue;
+
+        switch (spec.idle) {
+            case IdlePolicy::Spin:
+                _mm_pause();
+                break;
+            case IdlePolicy::Yield:
+                std::this_thread::yield();
+                break;
+            case IdlePolicy::Sleep:
+                std::this_thread::sleep_for(std::chrono::microseconds(spec.sleep_us));
+                break;
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/framework.h"
+
+// 线程空闲时的等待策略
+enum class IdlePolicy {
+    Spin,  // _mm_pause 自旋 (独占核)
+    Yield, // sched_yield
+    Sleep  // 休眠 sleep_us 微秒
+};
+
+// 配置项 "threads" 中的一个线程
+struct ThreadSpec {
+    std::string name;
+    int core = -1;          // 绑定的 CPU，-1 表示不绑核
+    bool fifo = false;      // SCHED_FIFO 实时调度
+    int priority = 0;       // SCHED_FIFO 优先级 (1-99)
+    IdlePolicy idle = IdlePolicy::Spin;
+    int sleep_us = 100;
+};
+
+// --- 引擎线程模型 ---
+// 由引擎持有的一组命名线程，模块在 init() 中把轮询函数注册上来。
+// 名为 "main" 的线程不会新建，而是在 HftEngine::run() 的调用线程上执行。
+class ThreadModel {
+public:
+    static constexpr const char* kMainThread = "main";
+
+    ThreadModel() = default;
+    ~ThreadModel();
+
+    void configure(const std::vector<ThreadSpec>& specs);
+    bool add_poller(const std::string& thread_name, const std::string& owner, Poller poller);
+
+    // 该模块是否在任一线程上注册了轮询函数
+    bool has_pollers(const std::string& owner) const;
+
+    void start();
+    void stop();
+
+    // 在调用线程上运行 "main" 线程的轮询循环，直到 deadline 或 stop()
+    // 没有 "main" 线程或其上没有轮询函数时返回 false，由调用方自行等待
+    bool run_main(std::chrono::steady_clock::time_point deadline);
+
+private:
+    struct PollEntry {
+        Poller poller;
+        std::string owner;
+    };
+
+    struct EngineThread {
+        ThreadSpec spec;
+        std::vector<PollEntry> pollers;
+        std::thread worker;
+        std::atomic<bool> running{false};
+
+        void apply_sched();
+        void loop(std::chrono::steady_clock::time_point deadline);
+    };
+
+    EngineThread* find(const std::string& name);
+
+    std::vector<std::unique_ptr<EngineThread>> threads_;
+    bool started_ = false;
+};